@@ -0,0 +1,612 @@
+// Benchmark suite for the core inventory operations on generated datasets.
+// Each dataset size runs in its own child process. Results go to stdout as
+// JSON Lines, one object per benchmark:
+//
+//   {"bench":"find","items":100000,"ops":100000,"seconds":0.004,
+//    "ops_per_sec":2.5e+07,"p50_ns":38,"p99_ns":95,"peak_rss_kb":20480,
+//    "rss_growth_kb":0}
+//
+// Per-item operations (add, find, delete) time a sample of individual calls
+// for the percentiles; whole-inventory operations (sort, search, load, save)
+// count one op per call and take percentiles over the repetitions.
+//
+// peak_rss_kb is the peak since the previous benchmark reported, setup such
+// as copying the inventory included, and rss_growth_kb how far it rose above
+// the RSS at that point. On Linux the peak is reset between benchmarks
+// through /proc/self/clear_refs; elsewhere it is the process peak so far.
+//
+// Usage: bench_inventory [ITEMS...]
+// Without arguments it runs 1k, 10k, ... up to BENCH_MAX_ITEMS (default 1M;
+// set it to 10000000 for the largest dataset).
+#define _POSIX_C_SOURCE 200809L
+#include "inventory.h"
+#include "csv_io.h"
+#include "snapshot.h"
+#include "inventory_publisher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define DEFAULT_MAX_ITEMS 1000000
+#define MAX_SAMPLES 100000
+#define MAX_RESULTS 1000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long rss_window_start_kb;  // RSS when the current benchmark began
+
+// A "Name: value kB" line of /proc/self/status, or -1 where there is none
+static long proc_status_kb(const char *field) {
+    FILE *file = fopen("/proc/self/status", "r");
+    if (!file) {
+        return -1;
+    }
+    
+    char line[256];
+    long kb = -1;
+    size_t length = strlen(field);
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, field, length) == 0 && line[length] == ':') {
+            kb = atol(line + length + 1);
+            break;
+        }
+    }
+    fclose(file);
+    return kb;
+}
+
+static long peak_rss_kb(void) {
+    long kb = proc_status_kb("VmHWM");
+    if (kb >= 0) {
+        return kb;
+    }
+    
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Starts a new peak RSS window for the next benchmark
+static void reset_peak_rss(void) {
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+    if (file) {
+        fputs("5", file);
+        fclose(file);
+    }
+    long kb = proc_status_kb("VmRSS");
+    rss_window_start_kb = kb >= 0 ? kb : peak_rss_kb();
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double *samples, int count, double p) {
+    int rank = (int)(p * count + 0.999999);
+    return samples[(rank > 0 ? rank : 1) - 1];
+}
+
+static void report(const char *bench, int items, long ops, double seconds, double *samples, int sample_count) {
+    long peak = peak_rss_kb();
+    qsort(samples, (size_t)sample_count, sizeof(double), compare_doubles);
+    printf("{\"bench\":\"%s\",\"items\":%d,\"ops\":%ld,\"seconds\":%.6f,\"ops_per_sec\":%.6g,"
+           "\"p50_ns\":%.0f,\"p99_ns\":%.0f,\"peak_rss_kb\":%ld,\"rss_growth_kb\":%ld}\n",
+           bench, items, ops, seconds, seconds > 0 ? ops / seconds : 0.0,
+           percentile(samples, sample_count, 0.50) * 1e9, percentile(samples, sample_count, 0.99) * 1e9,
+           peak, peak > rss_window_start_kb ? peak - rss_window_start_kb : 0);
+    fflush(stdout);
+    reset_peak_rss();
+}
+
+// Whole-inventory operations repeat fewer times as the dataset grows
+static int repetitions(int items) {
+    return items <= 10000 ? 20 : items <= 1000000 ? 5 : 3;
+}
+
+static void shuffle(int *values, int count) {
+    for (int i = count - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int temp = values[i];
+        values[i] = values[j];
+        values[j] = temp;
+    }
+}
+
+typedef struct {
+    int items;
+    char (*names)[MAX_NAME_LENGTH];
+    int *quantities;
+    float *prices;
+    int *ids;        // 1..items in random order
+    double *samples;
+    int stride;      // Per-item benchmarks time every stride-th call
+} Dataset;
+
+static bool dataset_generate(Dataset *data, int items) {
+    static const char *words[] = {"Gaming", "Laptop", "Wireless", "Mouse", "Mechanical", "Keyboard",
+                                  "USB-C", "Cable", "Monitor", "Stand", "Office", "Chair"};
+    int word_count = sizeof(words) / sizeof(words[0]);
+    
+    data->items = items;
+    data->names = malloc(sizeof(*data->names) * (size_t)items);
+    data->quantities = malloc(sizeof(int) * (size_t)items);
+    data->prices = malloc(sizeof(float) * (size_t)items);
+    data->ids = malloc(sizeof(int) * (size_t)items);
+    data->samples = malloc(sizeof(double) * MAX_SAMPLES);
+    data->stride = items > MAX_SAMPLES ? items / MAX_SAMPLES : 1;
+    if (!data->names || !data->quantities || !data->prices || !data->ids || !data->samples) {
+        return false;
+    }
+    
+    srand(42);
+    for (int i = 0; i < items; i++) {
+        snprintf(data->names[i], MAX_NAME_LENGTH, "%s %s %s %d", words[rand() % word_count],
+                 words[rand() % word_count], words[rand() % word_count], rand() % 1000);
+        data->quantities[i] = rand() % 1000;
+        data->prices[i] = (float)(rand() % 100000) / 100.0f;
+        data->ids[i] = i + 1;
+    }
+    shuffle(data->ids, items);
+    return true;
+}
+
+static void dataset_free(Dataset *data) {
+    free(data->names);
+    free(data->quantities);
+    free(data->prices);
+    free(data->ids);
+    free(data->samples);
+}
+
+// Adds every generated item to an empty inventory, growth included
+static void bench_add(Dataset *data, Inventory *inv) {
+    int sample_count = 0;
+    double start = now_seconds();
+    for (int i = 0; i < data->items; i++) {
+        if (i % data->stride == 0 && sample_count < MAX_SAMPLES) {
+            double t = now_seconds();
+            inventory_add_item(inv, data->names[i], data->quantities[i], data->prices[i]);
+            data->samples[sample_count++] = now_seconds() - t;
+        } else {
+            inventory_add_item(inv, data->names[i], data->quantities[i], data->prices[i]);
+        }
+    }
+    report("add", data->items, data->items, now_seconds() - start, data->samples, sample_count);
+}
+
+static void bench_find(Dataset *data, Inventory *inv) {
+    int sample_count = 0;
+    long found = 0;
+    double start = now_seconds();
+    for (int i = 0; i < data->items; i++) {
+        if (i % data->stride == 0 && sample_count < MAX_SAMPLES) {
+            double t = now_seconds();
+            found += inventory_find_by_id(inv, data->ids[i]) != NULL;
+            data->samples[sample_count++] = now_seconds() - t;
+        } else {
+            found += inventory_find_by_id(inv, data->ids[i]) != NULL;
+        }
+    }
+    double seconds = now_seconds() - start;
+    if (found != data->items) {
+        fprintf(stderr, "find: %ld of %d items found\n", found, data->items);
+    }
+    report("find", data->items, data->items, seconds, data->samples, sample_count);
+}
+
+// Deletes every item in random order from a copy without sort views, as
+// after a fresh load
+static void bench_delete(Dataset *data, const Inventory *inv) {
+    Inventory copy;
+    inventory_init(&copy);
+    if (!inventory_copy(&copy, inv)) {
+        fprintf(stderr, "delete: out of memory\n");
+        return;
+    }
+    
+    int sample_count = 0;
+    double start = now_seconds();
+    for (int i = 0; i < data->items; i++) {
+        if (i % data->stride == 0 && sample_count < MAX_SAMPLES) {
+            double t = now_seconds();
+            inventory_delete_item(&copy, data->ids[i]);
+            data->samples[sample_count++] = now_seconds() - t;
+        } else {
+            inventory_delete_item(&copy, data->ids[i]);
+        }
+    }
+    report("delete", data->items, data->items, now_seconds() - start, data->samples, sample_count);
+    inventory_free(&copy);
+}
+
+// One batch adjusting every item's quantity on a copy sorted by quantity,
+// so the batch has to merge its changes back into a built view
+static void bench_adjust_batch(Dataset *data, const Inventory *inv) {
+    Inventory copy;
+    inventory_init(&copy);
+    InventoryOp *ops = malloc((size_t)data->items * sizeof(InventoryOp));
+    InventoryOpResult *results = malloc((size_t)data->items * sizeof(InventoryOpResult));
+    if (!ops || !results || !inventory_copy(&copy, inv)) {
+        fprintf(stderr, "adjust_batch: out of memory\n");
+        free(ops);
+        free(results);
+        inventory_free(&copy);
+        return;
+    }
+    
+    for (int i = 0; i < data->items; i++) {
+        ops[i] = (InventoryOp){INVENTORY_OP_ADJUST_QUANTITY, data->ids[i], NULL, i % 5 + 1, 0.0f};
+    }
+    inventory_sort(&copy, SORT_BY_QUANTITY, true);
+    double t = now_seconds();
+    bool applied = inventory_apply_batch(&copy, ops, data->items, results);
+    data->samples[0] = now_seconds() - t;
+    if (!applied) {
+        fprintf(stderr, "adjust_batch: batch failed\n");
+    }
+    report("adjust_batch", data->items, data->items, data->samples[0], data->samples, 1);
+    
+    free(ops);
+    free(results);
+    inventory_free(&copy);
+}
+
+// Adds, updates and deletes every item on a copy sorted by name, so each
+// edit also has to keep the view in order
+static void bench_sorted_edits(Dataset *data, const Inventory *inv) {
+    Inventory copy;
+    inventory_init(&copy);
+    if (!inventory_copy(&copy, inv)) {
+        fprintf(stderr, "sorted edits: out of memory\n");
+        return;
+    }
+    inventory_sort(&copy, SORT_BY_NAME, true);
+    
+    int sample_count = 0;
+    double start = now_seconds();
+    for (int i = 0; i < data->items; i++) {
+        if (i % data->stride == 0 && sample_count < MAX_SAMPLES) {
+            double t = now_seconds();
+            inventory_add_item(&copy, data->names[i], data->quantities[i], data->prices[i]);
+            data->samples[sample_count++] = now_seconds() - t;
+        } else {
+            inventory_add_item(&copy, data->names[i], data->quantities[i], data->prices[i]);
+        }
+    }
+    report("add_sorted", data->items, data->items, now_seconds() - start, data->samples, sample_count);
+    
+    // Each item takes another item's name, so it moves within the view
+    sample_count = 0;
+    start = now_seconds();
+    for (int i = 0; i < data->items; i++) {
+        const char *name = data->names[data->items - 1 - i];
+        if (i % data->stride == 0 && sample_count < MAX_SAMPLES) {
+            double t = now_seconds();
+            inventory_update_item(&copy, data->ids[i], name, data->quantities[i] + 1, data->prices[i]);
+            data->samples[sample_count++] = now_seconds() - t;
+        } else {
+            inventory_update_item(&copy, data->ids[i], name, data->quantities[i] + 1, data->prices[i]);
+        }
+    }
+    report("update_sorted", data->items, data->items, now_seconds() - start, data->samples, sample_count);
+    
+    sample_count = 0;
+    start = now_seconds();
+    for (int i = 0; i < data->items; i++) {
+        if (i % data->stride == 0 && sample_count < MAX_SAMPLES) {
+            double t = now_seconds();
+            inventory_delete_item(&copy, data->ids[i]);
+            data->samples[sample_count++] = now_seconds() - t;
+        } else {
+            inventory_delete_item(&copy, data->ids[i]);
+        }
+    }
+    report("delete_sorted", data->items, data->items, now_seconds() - start, data->samples, sample_count);
+    inventory_free(&copy);
+}
+
+// Sets a reorder level on every item of a copy whose reorder heap is
+// already built, then reads the top of the list repeatedly
+static void bench_reorder(Dataset *data, const Inventory *inv) {
+    Inventory copy;
+    inventory_init(&copy);
+    int ids[MAX_RESULTS];
+    if (!inventory_copy(&copy, inv) || inventory_reorder_list(&copy, ids, 1) == -1) {
+        fprintf(stderr, "reorder: out of memory\n");
+        inventory_free(&copy);
+        return;
+    }
+    
+    int sample_count = 0;
+    double start = now_seconds();
+    for (int i = 0; i < data->items; i++) {
+        int level = data->quantities[i] % 7 * 100;
+        if (i % data->stride == 0 && sample_count < MAX_SAMPLES) {
+            double t = now_seconds();
+            inventory_set_reorder_level(&copy, data->ids[i], level);
+            data->samples[sample_count++] = now_seconds() - t;
+        } else {
+            inventory_set_reorder_level(&copy, data->ids[i], level);
+        }
+    }
+    report("reorder_set_level", data->items, data->items, now_seconds() - start, data->samples, sample_count);
+    
+    int reps = repetitions(data->items) * 20;
+    double total = 0.0;
+    for (int r = 0; r < reps; r++) {
+        double t = now_seconds();
+        inventory_reorder_list(&copy, ids, MAX_RESULTS);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+    }
+    report("reorder_list_1000", data->items, reps, total, data->samples, reps);
+    inventory_free(&copy);
+}
+
+// The first publish copies everything; after a one-item edit a publish
+// copies one chunk and compares the display order
+static void bench_publish(Dataset *data, const Inventory *inv) {
+    Inventory copy;
+    inventory_init(&copy);
+    InventoryPublisher publisher;
+    inventory_publisher_init(&publisher);
+    int *ids = malloc(sizeof(int) * MAX_RESULTS);
+    bool ok = ids && inventory_copy(&copy, inv);
+    double t = now_seconds();
+    if (!ok || !inventory_publisher_publish(&publisher, &copy)) {
+        fprintf(stderr, "publish: out of memory\n");
+        inventory_publisher_free(&publisher);
+        inventory_free(&copy);
+        free(ids);
+        return;
+    }
+    data->samples[0] = now_seconds() - t;
+    report("publish_full", data->items, 1, data->samples[0], data->samples, 1);
+    
+    int reps = repetitions(data->items) * 20;
+    double total = 0.0;
+    for (int r = 0; r < reps; r++) {
+        int id = data->ids[(r * 7919) % data->items];
+        inventory_update_item(&copy, id, data->names[(r * 7919) % data->items], r, 1.5f);
+        t = now_seconds();
+        inventory_publisher_publish(&publisher, &copy);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+    }
+    report("publish_after_update", data->items, reps, total, data->samples, reps);
+    
+    // Readers query the version without the live inventory
+    int reader = inventory_publisher_register(&publisher);
+    reps = repetitions(data->items);
+    total = 0.0;
+    for (int r = 0; r < reps; r++) {
+        t = now_seconds();
+        const InventoryVersion *version = inventory_publisher_enter(&publisher, reader);
+        inventory_version_search(version, "e", ids, MAX_RESULTS);
+        inventory_publisher_exit(&publisher, reader);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+    }
+    report("version_search_scan", data->items, reps, total, data->samples, reps);
+    inventory_publisher_unregister(&publisher, reader);
+    
+    inventory_publisher_free(&publisher);
+    inventory_free(&copy);
+    free(ids);
+}
+
+// Each repetition sorts a fresh copy, so the view is built from scratch
+static void bench_sort(Dataset *data, const Inventory *inv, SortCriteria criteria, bool ascending) {
+    static const char *criteria_names[] = {"id", "name", "quantity", "price"};
+    int reps = repetitions(data->items);
+    double total = 0.0;
+    
+    for (int r = 0; r < reps; r++) {
+        Inventory copy;
+        inventory_init(&copy);
+        if (!inventory_copy(&copy, inv)) {
+            fprintf(stderr, "sort: out of memory\n");
+            return;
+        }
+        double t = now_seconds();
+        inventory_sort(&copy, criteria, ascending);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+        inventory_free(&copy);
+    }
+    
+    char bench[64];
+    snprintf(bench, sizeof(bench), "sort_%s_%s", criteria_names[criteria], ascending ? "asc" : "desc");
+    report(bench, data->items, reps, total, data->samples, reps);
+}
+
+// Two-key stable sort (quantity, then name descending) of a fresh copy,
+// which runs on every core for large inventories
+static void bench_sort_keys(Dataset *data, const Inventory *inv) {
+    static const InventorySortKey keys[] = {{SORT_BY_QUANTITY, true}, {SORT_BY_NAME, false}};
+    int reps = repetitions(data->items);
+    double total = 0.0;
+    
+    for (int r = 0; r < reps; r++) {
+        Inventory copy;
+        inventory_init(&copy);
+        if (!inventory_copy(&copy, inv)) {
+            fprintf(stderr, "sort_keys: out of memory\n");
+            return;
+        }
+        double t = now_seconds();
+        inventory_sort_by_keys(&copy, keys, 2);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+        inventory_free(&copy);
+    }
+    report("sort_keys_quantity_name", data->items, reps, total, data->samples, reps);
+}
+
+// The first indexed search builds the trigram index; later ones reuse it
+static void bench_search(Dataset *data, Inventory *inv) {
+    static const struct {
+        const char *bench;
+        const char *query;
+    } cases[] = {
+        {"search_index_build", "keyboard"},
+        {"search_indexed", "mouse 42"},
+        {"search_indexed_miss", "not-present"},
+        {"search_scan", "e"},
+        {"search_all", ""},
+    };
+    int *ids = malloc(sizeof(int) * MAX_RESULTS);
+    if (!ids) {
+        return;
+    }
+    
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        int reps = c == 0 ? 1 : repetitions(data->items);
+        double total = 0.0;
+        for (int r = 0; r < reps; r++) {
+            double t = now_seconds();
+            inventory_search(inv, cases[c].query, ids, MAX_RESULTS, NULL, NULL);
+            data->samples[r] = now_seconds() - t;
+            total += data->samples[r];
+        }
+        report(cases[c].bench, data->items, reps, total, data->samples, reps);
+    }
+    free(ids);
+}
+
+// Saves and reloads both file formats; freeing the loaded copy is not timed
+static void bench_files(Dataset *data, Inventory *inv) {
+    char csv_filename[64], snapshot_filename[64];
+    snprintf(csv_filename, sizeof(csv_filename), "bench_inventory_%ld.csv", (long)getpid());
+    snprintf(snapshot_filename, sizeof(snapshot_filename), "bench_inventory_%ld.snapshot", (long)getpid());
+    int reps = repetitions(data->items);
+    double total;
+    
+    total = 0.0;
+    for (int r = 0; r < reps; r++) {
+        double t = now_seconds();
+        save_inventory_to_file(inv, csv_filename);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+    }
+    report("save_csv", data->items, reps, total, data->samples, reps);
+    
+    total = 0.0;
+    for (int r = 0; r < reps; r++) {
+        double t = now_seconds();
+        snapshot_save(inv, snapshot_filename, csv_filename);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+    }
+    report("save_snapshot", data->items, reps, total, data->samples, reps);
+    
+    total = 0.0;
+    for (int r = 0; r < reps; r++) {
+        Inventory loaded;
+        inventory_init(&loaded);
+        double t = now_seconds();
+        bool ok = load_inventory_from_file(&loaded, csv_filename);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+        if (!ok || loaded.count != inv->count) {
+            fprintf(stderr, "load_csv: loaded %d of %d items\n", loaded.count, inv->count);
+        }
+        inventory_free(&loaded);
+    }
+    report("load_csv", data->items, reps, total, data->samples, reps);
+    
+    total = 0.0;
+    for (int r = 0; r < reps; r++) {
+        Inventory loaded;
+        inventory_init(&loaded);
+        double t = now_seconds();
+        bool ok = snapshot_load(&loaded, snapshot_filename, csv_filename);
+        data->samples[r] = now_seconds() - t;
+        total += data->samples[r];
+        if (!ok || loaded.count != inv->count) {
+            fprintf(stderr, "load_snapshot: loaded %d of %d items\n", loaded.count, inv->count);
+        }
+        inventory_free(&loaded);
+    }
+    report("load_snapshot", data->items, reps, total, data->samples, reps);
+    
+    unlink(csv_filename);
+    unlink(snapshot_filename);
+}
+
+static int run_size(int items) {
+    Dataset data;
+    if (!dataset_generate(&data, items)) {
+        fprintf(stderr, "%d items: out of memory\n", items);
+        dataset_free(&data);
+        return 1;
+    }
+    
+    Inventory inv;
+    inventory_init(&inv);
+    reset_peak_rss();
+    bench_add(&data, &inv);
+    bench_find(&data, &inv);
+    bench_search(&data, &inv);
+    bench_files(&data, &inv);
+    for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+        bench_sort(&data, &inv, (SortCriteria)c, true);
+        bench_sort(&data, &inv, (SortCriteria)c, false);
+    }
+    bench_sort_keys(&data, &inv);
+    bench_adjust_batch(&data, &inv);
+    bench_reorder(&data, &inv);
+    bench_publish(&data, &inv);
+    bench_sorted_edits(&data, &inv);
+    bench_delete(&data, &inv);
+    
+    inventory_free(&inv);
+    dataset_free(&data);
+    return 0;
+}
+
+static int run_size_in_child(int items) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == -1) {
+        return run_size(items);
+    }
+    if (pid == 0) {
+        _exit(run_size(items));
+    }
+    
+    int status;
+    if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%d items: benchmark failed\n", items);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int failures = 0;
+    
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            failures += run_size_in_child(atoi(argv[i]));
+        }
+        return failures ? 1 : 0;
+    }
+    
+    const char *max_env = getenv("BENCH_MAX_ITEMS");
+    long max_items = max_env ? atol(max_env) : DEFAULT_MAX_ITEMS;
+    for (long items = 1000; items <= max_items; items *= 10) {
+        failures += run_size_in_child((int)items);
+    }
+    return failures ? 1 : 0;
+}
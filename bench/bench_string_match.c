@@ -0,0 +1,99 @@
+// Micro-benchmark: case-insensitive substring matching over item names.
+// Compares the original g_ascii_strdown + strstr implementation against
+// string_contains_ignore_case and a StringMatcher prepared once per query.
+#define _POSIX_C_SOURCE 199309L
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#define NAME_COUNT 200000
+#define ROUNDS 10
+
+// Stand-in for g_ascii_strdown, so the benchmark links without GLib
+static char *ascii_strdown(const char *str) {
+    size_t length = strlen(str);
+    char *lower = malloc(length + 1);
+    for (size_t i = 0; i <= length; i++) {
+        lower[i] = (char)tolower((unsigned char)str[i]);
+    }
+    return lower;
+}
+
+static bool legacy_contains_ignore_case(const char *haystack, const char *needle) {
+    char *haystack_lower = ascii_strdown(haystack);
+    char *needle_lower = ascii_strdown(needle);
+    bool result = (strstr(haystack_lower, needle_lower) != NULL);
+    free(haystack_lower);
+    free(needle_lower);
+    return result;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *variant, const char *query, double seconds, long matches) {
+    double calls = (double)NAME_COUNT * ROUNDS;
+    printf("%-10s query=%-12s %8.1f ns/call  matches=%ld\n", variant, query, seconds * 1e9 / calls, matches);
+}
+
+int main(void) {
+    static const char *words[] = {"Gaming", "Laptop", "Wireless", "Mouse", "Mechanical", "Keyboard",
+                                  "USB-C", "Cable", "Monitor", "Stand", "Office", "Chair"};
+    static const char *queries[] = {"mouse", "KEYBOARD", "e", "cable 1", "not-present"};
+    int word_count = sizeof(words) / sizeof(words[0]);
+    
+    char (*names)[MAX_NAME_LENGTH] = malloc(sizeof(*names) * NAME_COUNT);
+    size_t *lengths = malloc(sizeof(size_t) * NAME_COUNT);
+    if (!names || !lengths) {
+        return 1;
+    }
+    
+    srand(42);
+    for (int i = 0; i < NAME_COUNT; i++) {
+        snprintf(names[i], MAX_NAME_LENGTH, "%s %s %s %d", words[rand() % word_count],
+                 words[rand() % word_count], words[rand() % word_count], rand() % 1000);
+        lengths[i] = strlen(names[i]);
+    }
+    
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const char *query = queries[q];
+        long matches = 0;
+        double start = now_seconds();
+        for (int r = 0; r < ROUNDS; r++) {
+            for (int i = 0; i < NAME_COUNT; i++) {
+                matches += legacy_contains_ignore_case(names[i], query);
+            }
+        }
+        report("legacy", query, now_seconds() - start, matches);
+        
+        matches = 0;
+        start = now_seconds();
+        for (int r = 0; r < ROUNDS; r++) {
+            for (int i = 0; i < NAME_COUNT; i++) {
+                matches += string_contains_ignore_case(names[i], query);
+            }
+        }
+        report("contains", query, now_seconds() - start, matches);
+        
+        matches = 0;
+        start = now_seconds();
+        for (int r = 0; r < ROUNDS; r++) {
+            StringMatcher matcher;
+            string_matcher_init(&matcher, query);
+            for (int i = 0; i < NAME_COUNT; i++) {
+                matches += string_matcher_find(&matcher, names[i], lengths[i]);
+            }
+        }
+        report("matcher", query, now_seconds() - start, matches);
+    }
+    
+    free(names);
+    free(lengths);
+    return 0;
+}
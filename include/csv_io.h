@@ -0,0 +1,31 @@
+#ifndef CSV_IO_H
+#define CSV_IO_H
+
+#include <stdbool.h>
+#include "inventory.h"
+#include "inventory_publisher.h"
+#include "file_util.h"
+
+// Inventory files are CSV with an "ID,Name,Quantity,Price,Reorder Level"
+// header; files without the last column load with no reorder levels. Names
+// may be quoted; inside quotes a comma is literal and "" stands for one quote.
+// Saves go through an AtomicFile, so a crash leaves either the old file or
+// the new one intact.
+bool save_inventory_to_file(const Inventory *inv, const char *filename);
+
+// First half of a save: writes and syncs the temp file but leaves replacing
+// filename to atomic_file_replace (or atomic_file_abort)
+bool save_inventory_to_temp_file(const Inventory *inv, const char *filename, AtomicFile *output);
+
+// Writes a published version the same way, rows in its display order, from
+// any thread while the inventory it came from keeps changing
+bool save_inventory_version_to_file(const InventoryVersion *version, const char *filename);
+bool save_inventory_version_to_temp_file(const InventoryVersion *version, const char *filename, AtomicFile *output);
+
+// Replaces the inventory with the file's rows. Large files are mapped and
+// parsed on several threads; rows with a bad or repeated id are skipped.
+// Returns false, leaving the inventory untouched, if the file cannot be read,
+// or empty if it runs out of memory while filling it in.
+bool load_inventory_from_file(Inventory *inv, const char *filename);
+
+#endif
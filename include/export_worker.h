@@ -0,0 +1,35 @@
+#ifndef EXPORT_WORKER_H
+#define EXPORT_WORKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "inventory_publisher.h"
+
+// Called on the worker thread once the export is over; version is the
+// inventory version that was written
+typedef void (*ExportWorkerCallback)(bool ok, uint64_t version, void *user_data);
+
+// Background thread that writes the latest published version of the
+// inventory to a CSV file. It reads the version through the publisher, so
+// the inventory stays editable the whole time and nothing is copied up front.
+typedef struct {
+    InventoryPublisher *publisher;
+    const char *filename;
+    ExportWorkerCallback callback;
+    void *user_data;
+    pthread_t thread;
+    bool threaded;
+    bool ok;
+    uint64_t version;
+} ExportWorker;
+
+// Publish the inventory before starting. Returns false, without calling
+// back, if the thread cannot be started.
+bool export_worker_start(ExportWorker *worker, InventoryPublisher *publisher, const char *filename,
+                         ExportWorkerCallback callback, void *user_data);
+
+// Waits for the thread to exit; ok and version are final afterwards
+void export_worker_join(ExportWorker *worker);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef FILE_UTIL_H
+#define FILE_UTIL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Read-only view of a whole file: mmap'd where available, otherwise read
+// into one malloc'd buffer. data is NULL for an empty file.
+typedef struct {
+    const char *data;
+    size_t size;
+    bool mapped;
+} MappedFile;
+
+bool mapped_file_open(MappedFile *file, const char *filename);
+void mapped_file_close(MappedFile *file);
+
+// Writes go to "<filename>.tmp"; commit syncs it to disk and renames it over
+// filename, so readers (and a crash) only ever see the old or the new file
+typedef struct {
+    FILE *file;
+    char *temp_filename;
+    const char *filename;
+} AtomicFile;
+
+bool atomic_file_open(AtomicFile *file, const char *filename);
+bool atomic_file_commit(AtomicFile *file);
+void atomic_file_abort(AtomicFile *file);
+
+// commit in two steps: finish syncs and closes the temp file (which callers
+// may then inspect via temp_filename), replace renames it into place. Both
+// consume the file on failure.
+bool atomic_file_finish(AtomicFile *file);
+bool atomic_file_replace(AtomicFile *file);
+
+// Identifies one version of a file. A file replaced by rename gets a new
+// inode, and mtime keeps nanoseconds, so an in-place rewrite of the same
+// size within the same second still changes the stamp.
+typedef struct {
+    uint64_t size;
+    int64_t mtime_ns;  // Nanoseconds since the epoch; whole seconds where the platform has no more
+    uint64_t inode;    // 0 where the platform has none
+} FileStamp;
+
+bool file_stamp_get(const char *filename, FileStamp *stamp);
+bool file_stamp_equal(const FileStamp *a, const FileStamp *b);
+
+// fflush plus fsync (or _commit on Windows)
+bool file_sync(FILE *file);
+
+#endif
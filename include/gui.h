@@ -3,6 +3,34 @@
 
 #include <gtk/gtk.h>
 #include "inventory.h"
+#include "journal.h"
+#include "save_worker.h"
+#include "load_worker.h"
+#include "inventory_model.h"
+#include "search_worker.h"
+#include "export_worker.h"
+#include "inventory_publisher.h"
+#include "metrics.h"
+
+// Unsaved changes are written in the background this often
+#define AUTOSAVE_INTERVAL_SECONDS 30
+
+// Typing pauses this long before the search runs
+#define SEARCH_DEBOUNCE_MS 150
+
+// The Performance view refreshes this often while it is open
+#define PERFORMANCE_REFRESH_MS 1000
+
+// The Reorder view lists at most this many of the items furthest below
+// their reorder level
+#define REORDER_VIEW_LIMIT 200
+
+// With STOCKFLOW_METRICS_FILE set, the histograms are written there this often
+#define METRICS_DUMP_INTERVAL_SECONDS 60
+
+// The status bar counts items with fewer units than this as low on stock;
+// one of INVENTORY_LOW_STOCK_LIMITS, so the count is kept as a running total
+#define LOW_STOCK_THRESHOLD 10
 
 // Column identifiers for TreeView
 enum {
@@ -15,18 +43,39 @@ enum {
 
 typedef struct {
     GtkWidget *window;
+    GtkWidget *toolbar;
+    GtkWidget *input_frame;
     GtkWidget *tree_view;
-    GtkListStore *list_store;
+    InventoryModel *model;
     GtkWidget *search_entry;
     GtkWidget *name_entry;
     GtkWidget *quantity_entry;
     GtkWidget *price_entry;
+    GtkWidget *reorder_entry;
     GtkWidget *add_button;
     GtkWidget *update_button;
     GtkWidget *delete_button;
     GtkWidget *status_label;
+    GtkWidget *totals_label;  // Live item, unit, value and low-stock totals
     
     Inventory *inventory;
+    Journal *journal;  // NULL if the journal could not be opened
+    SaveWorker *save_worker;   // NULL if the thread could not be started
+    bool manual_save_pending;  // The running save was started by the Save button
+    LoadWorker *load_worker;   // Set until the startup load thread has been joined
+    bool loading;              // Editing stays disabled until the load is done
+    SearchWorker *search_worker;  // NULL if the thread could not be started
+    guint search_timeout;         // Pending debounce, 0 if none
+    uint64_t search_generation;   // Latest search request; results of older ones are dropped
+    GtkWidget *performance_window;     // Open Performance view, or NULL
+    GtkListStore *performance_store;
+    guint performance_timeout;
+    GtkWidget *reorder_window;         // Open Reorder view, or NULL
+    GtkListStore *reorder_store;
+    InventoryPublisher *publisher;     // Versions of the inventory for background readers
+    ExportWorker export_worker;
+    bool exporting;                    // export_worker runs until on_export_finished joins it
+    const char *metrics_filename;      // Periodic metrics dump, or NULL
     int selected_id;
 } AppData;
 
@@ -36,11 +85,18 @@ void setup_tree_view(AppData *app_data);
 void setup_input_form(AppData *app_data, GtkWidget *container);
 void setup_toolbar(AppData *app_data, GtkWidget *container);
 
+// Modal message dialogs
+void show_error_dialog(GtkWidget *parent, const char *message);
+void show_info_dialog(GtkWidget *parent, const char *message);
+
 // GUI update functions
 void refresh_tree_view(AppData *app_data);
 void update_status(AppData *app_data, const char *message);
+void update_totals(AppData *app_data);
+void update_reorder_view(AppData *app_data);
 void clear_input_fields(AppData *app_data);
 void populate_input_fields(AppData *app_data, const InventoryItem *item);
+void set_loading(AppData *app_data, bool loading);
 
 // Signal handlers
 void on_add_button_clicked(GtkWidget *widget, gpointer data);
@@ -51,5 +107,27 @@ void on_search_entry_changed(GtkWidget *widget, gpointer data);
 void on_column_header_clicked(GtkTreeViewColumn *column, gpointer data);
 void on_save_clicked(GtkWidget *widget, gpointer data);
 void on_load_clicked(GtkWidget *widget, gpointer data);
+void on_performance_clicked(GtkWidget *widget, gpointer data);
+void on_reorder_clicked(GtkWidget *widget, gpointer data);
+void on_export_clicked(GtkWidget *widget, gpointer data);
+
+// Background saving
+gboolean on_autosave_timeout(gpointer data);
+void on_save_finished(bool ok, uint64_t version, void *user_data);
+
+// Background export
+void on_export_finished(bool ok, uint64_t version, void *user_data);
+
+// Background search
+void on_search_finished(int *ids, int count, uint64_t generation, uint64_t version, void *user_data);
+
+// Row-level table updates from the inventory
+void on_inventory_changed(const InventoryChange *change, void *user_data);
+
+// Performance metrics
+gboolean on_metrics_dump_timeout(gpointer data);
+
+// Startup loading
+void on_load_finished(bool loaded, void *user_data);
 
 #endif
@@ -0,0 +1,29 @@
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <stdbool.h>
+
+// Open-addressing (linear probing) map from item id to slot in Inventory.items.
+// Ids must be positive; 0 marks an empty bucket.
+typedef struct {
+    int id;
+    int slot;
+} IdIndexEntry;
+
+typedef struct {
+    IdIndexEntry *entries;
+    int capacity;  // Always zero or a power of two
+    int shift;     // 32 - log2(capacity): buckets take the hash's top bits
+    int count;
+} IdIndex;
+
+void id_index_init(IdIndex *index);
+void id_index_free(IdIndex *index);
+void id_index_clear(IdIndex *index);
+bool id_index_copy(IdIndex *dst, const IdIndex *src);
+bool id_index_reserve(IdIndex *index, int min_count);
+bool id_index_put(IdIndex *index, int id, int slot);
+int id_index_get(const IdIndex *index, int id);
+bool id_index_remove(IdIndex *index, int id);
+
+#endif
@@ -2,42 +2,282 @@
 #define INVENTORY_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "id_index.h"
+#include "name_heap.h"
+#include "trigram_index.h"
+#include "slot_tree.h"
 
 #define MAX_NAME_LENGTH 50
-#define MAX_ITEMS 1000
+#define INVENTORY_INITIAL_CAPACITY 64
 
+// One row as a value. The inventory itself stores columns; this is what
+// accessors copy rows out into.
 typedef struct {
     int id;
     char name[MAX_NAME_LENGTH];
     int quantity;
     float price;
+    int reorder_level;  // Restock once quantity falls below this; 0 for never
 } InventoryItem;
 
+// Sorting functions
+typedef enum {
+    SORT_BY_ID,
+    SORT_BY_NAME,
+    SORT_BY_QUANTITY,
+    SORT_BY_PRICE,
+    SORT_CRITERIA_COUNT
+} SortCriteria;
+
+// Per-item change notifications, so a view can update single rows instead of
+// rebuilding. Positions are in display order; old_position is -1 for an
+// added item and new_position is -1 for a removed one. A large batch sends
+// one INVENTORY_ITEMS_RESET (id and positions -1) instead: anything may have
+// changed, so views should reload.
+typedef enum {
+    INVENTORY_ITEM_ADDED,
+    INVENTORY_ITEM_UPDATED,
+    INVENTORY_ITEM_REMOVED,
+    INVENTORY_ITEMS_RESET
+} InventoryChangeType;
+
+typedef struct {
+    InventoryChangeType type;
+    int id;
+    int old_position;
+    int new_position;
+} InventoryChange;
+
+typedef void (*InventoryListener)(const InventoryChange *change, void *user_data);
+
+// Slots (row positions in the columns), kept ascending by (key, id) for one
+// criteria in a counted B+tree, so each change and each lookup by position
+// costs O(log n). Built on first use, then updated incrementally by every
+// mutation.
 typedef struct {
-    InventoryItem items[MAX_ITEMS];
+    SlotTree slots;
+    bool built;
+} SortedView;
+
+// Quantities below which an item counts as low stock in the running totals
+#define INVENTORY_LOW_STOCK_LIMITS {1, 5, 10, 25, 50, 100}
+#define INVENTORY_LOW_STOCK_LIMIT_COUNT 6
+
+// Running totals, kept up to date by every mutation so reading them is O(1).
+// Each price is rounded to whole cents once, so the sums are exact integers
+// and removing an item takes back exactly what adding it put in.
+typedef struct {
+    int64_t value_cents;  // Sum of quantity * price
+    int64_t units;        // Sum of quantities
+    int low_stock_counts[INVENTORY_LOW_STOCK_LIMIT_COUNT];  // Items below each limit
+} InventoryTotals;
+
+// Indexed binary min-heap of slots keyed on quantity - reorder_level (then
+// id), so the item furthest below its reorder level is on top. Built on
+// first use, then kept current by every mutation in O(log n).
+typedef struct {
+    int *slots;      // Heap order
+    int *positions;  // slots[positions[slot]] == slot
+    int length;
+    int capacity;
+    bool built;
+} ReorderHeap;
+
+// Slots are grouped into blocks of this many rows for change tracking; a
+// published version (see inventory_publisher.h) shares unchanged blocks
+#define INVENTORY_CHUNK_ROWS 1024
+
+// Columnar item store: row i ("slot" i) is ids[i], quantities[i], prices[i]
+// and the name at name_heap.data + name_offsets[i]. Scans over one field
+// touch only that field's array. Capacity grows geometrically so adds are
+// amortized O(1). Slots are kept dense (deletes move the last row into the
+// hole), so display order lives separately in order, where -1 marks a
+// deleted entry until deletes outnumber live entries and a mutation
+// compacts it. Reading the display order never compacts.
+typedef struct {
+    int *ids;
+    int *quantities;
+    float *prices;
+    int *reorder_levels;
+    uint32_t *name_offsets;
+    uint8_t *name_lengths;
+    uint64_t *chunk_stamps;  // Per block of slots: version it last changed at
+    NameHeap name_heap;
+    bool holding_names;      // Set while a batch applies, so compaction cannot undo its reservation
     int count;
+    int capacity;
     int next_id;
+    IdIndex id_index;  // id -> slot, kept in sync by every mutation
+    int *order;        // Display sequence of slots
+    int *order_pos;    // Slot i is listed at order[order_pos[i]]
+    int order_length;  // Entries in order, including deleted ones
+    int *order_live;   // Fenwick tree over order counting live entries, so positions skip deleted ones
+    SortedView views[SORT_CRITERIA_COUNT];
+    bool sorted;       // Display follows views[sort_criteria] instead of order
+    SortCriteria sort_criteria;
+    bool sort_ascending;
+    TrigramIndex name_index;  // Built on the first substring search, then kept current
+    ReorderHeap reorder_heap;  // Built on the first reorder query, then kept current
+    InventoryTotals totals;
+    InventoryItem row;        // Backing store for rows returned by pointer
+    uint64_t version;         // Bumped by every mutation
+    uint64_t saved_version;   // Version last written to disk; dirty while they differ
+    InventoryListener listener;  // Optional; called after each single-item mutation
+    void *listener_data;
 } Inventory;
 
+// Borrowed column arrays holding count rows in display order, used to load
+// an inventory in bulk (e.g. from a snapshot) without per-row inserts
+typedef struct {
+    int count;
+    int next_id;
+    const int *ids;
+    const int *quantities;
+    const float *prices;
+    const int *reorder_levels;     // NULL if every level is 0
+    const uint32_t *name_offsets;  // Into names
+    const uint8_t *name_lengths;
+    const char *names;             // NUL-terminated names
+    size_t names_size;
+} InventoryColumns;
+
 // Core inventory functions
 void inventory_init(Inventory *inv);
+void inventory_free(Inventory *inv);
+void inventory_clear(Inventory *inv);
+bool inventory_copy(Inventory *dst, const Inventory *src);
+bool inventory_is_dirty(const Inventory *inv);
+void inventory_mark_saved(Inventory *inv, uint64_t version);
+
+// Reports adds, updates and deletes synchronously on the mutating thread.
+// Bulk operations (clear, load_columns) are not reported; detach the
+// listener around loads and refresh the view afterwards. Pass NULL to detach.
+void inventory_set_listener(Inventory *inv, InventoryListener listener, void *user_data);
+bool inventory_reserve(Inventory *inv, int min_capacity);
+void inventory_shrink_to_fit(Inventory *inv);
 int inventory_add_item(Inventory *inv, const char *name, int quantity, float price);
+int inventory_insert_item(Inventory *inv, int id, const char *name, int quantity, float price);
+bool inventory_load_columns(Inventory *inv, const InventoryColumns *columns);
 bool inventory_update_item(Inventory *inv, int id, const char *name, int quantity, float price);
 bool inventory_delete_item(Inventory *inv, int id);
-InventoryItem* inventory_find_by_id(Inventory *inv, int id);
 int inventory_get_index_by_id(Inventory *inv, int id);
 
-// Sorting functions
+// Sets the level below which inventory_reorder_list reports an item; 0 (the
+// default) never reports it. Returns false for an unknown id or a negative
+// level.
+bool inventory_set_reorder_level(Inventory *inv, int id, int level);
+
+// Writes the ids of up to max_results items whose quantity is below their
+// reorder level, furthest below first. Walks only the top of the reorder
+// heap, so k results take O(k log k) however large the inventory (after a
+// one-off O(n) build). Returns the number written, or -1 if memory ran out.
+int inventory_reorder_list(Inventory *inv, int *ids, int max_results);
+
+// Batched mutations, e.g. receiving a purchase order. For an adjustment,
+// quantity is the amount to add (negative to remove stock).
 typedef enum {
-    SORT_BY_ID,
-    SORT_BY_NAME,
-    SORT_BY_QUANTITY,
-    SORT_BY_PRICE
-} SortCriteria;
+    INVENTORY_OP_ADD,
+    INVENTORY_OP_UPDATE,
+    INVENTORY_OP_DELETE,
+    INVENTORY_OP_ADJUST_QUANTITY
+} InventoryOpType;
+
+typedef struct {
+    InventoryOpType type;
+    int id;            // Ignored for adds
+    const char *name;  // Adds and updates
+    int quantity;      // Adds and updates; the delta for adjustments
+    float price;       // Adds and updates
+    int reorder_level; // Adds; 0 for none
+} InventoryOp;
 
+typedef enum {
+    INVENTORY_OP_OK,
+    INVENTORY_OP_SKIPPED,       // Valid, but not applied because another operation failed
+    INVENTORY_OP_INVALID,       // Empty name, or negative quantity or price
+    INVENTORY_OP_NOT_FOUND,     // No item with that id at this point in the batch
+    INVENTORY_OP_OUT_OF_RANGE,  // Adjustment would leave the quantity below 0 or above INT_MAX
+    INVENTORY_OP_NO_MEMORY
+} InventoryOpStatus;
+
+typedef struct {
+    InventoryOpStatus status;
+    int id;  // The item operated on; for adds, the new item's id
+} InventoryOpResult;
+
+// Checks every operation first, in order, against the inventory as the
+// earlier ones would leave it (adds take consecutive ids from next_id, so
+// later operations may refer to them). If any fails, or the memory they need
+// cannot be reserved, nothing is applied. Otherwise all are applied in one
+// pass, which cannot fail: the only thing that may still allocate is the
+// search index, and one that cannot grow is dropped and rebuilt by the next
+// search. A large batch merges its changes into each sort view at the end
+// and reports one INVENTORY_ITEMS_RESET instead of a change per item. Fills
+// results (one per operation) and returns true if everything was applied.
+bool inventory_apply_batch(Inventory *inv, const InventoryOp *ops, int count, InventoryOpResult *results);
+
+// Row access. Returned rows are copies held by the inventory and stay valid
+// until the next row access or mutation; change items through the functions
+// above.
+const InventoryItem* inventory_find_by_id(Inventory *inv, int id);
+bool inventory_get_item(const Inventory *inv, int id, InventoryItem *item);
+void inventory_read_slot(const Inventory *inv, int slot, InventoryItem *item);
+const char* inventory_name_at(const Inventory *inv, int slot);
+
+// Display order access; position runs from 0 to count - 1
+const InventoryItem* inventory_item_at(Inventory *inv, int position);
+int inventory_slot_at(Inventory *inv, int position);
+void inventory_compact_order(Inventory *inv);
+
+// Copies the slots at positions [first, first + count) to slots, a block at a
+// time rather than one lookup per position
+void inventory_read_display(Inventory *inv, int first, int count, int *slots);
+
+// Stock value and units come from the running totals. Low-stock counts do
+// too when threshold is one of INVENTORY_LOW_STOCK_LIMITS; any other
+// threshold scans the quantity column.
+double inventory_stock_value(const Inventory *inv);
+int64_t inventory_stock_value_cents(const Inventory *inv);
+int64_t inventory_total_units(const Inventory *inv);
+int inventory_count_low_stock(const Inventory *inv, int threshold);
+
+// Whole cents for a price, rounded as the CSV files write it and clamped to
+// +/-10^15 cents; the unit the running totals count in
+int64_t inventory_price_cents(float price);
+
+// Switches the display to a sorted view; O(1) once that view exists
 void inventory_sort(Inventory *inv, SortCriteria criteria, bool ascending);
 
-// Search functions
-int inventory_search(Inventory *inv, const char *query, InventoryItem *results, int max_results);
+// One key of a multi-key sort
+typedef struct {
+    SortCriteria criteria;
+    bool ascending;
+} InventorySortKey;
+
+#define INVENTORY_MAX_SORT_KEYS 8
+
+// Rearranges the display order by several keys in turn, e.g. quantity
+// ascending, then name, then id. Stable: items equal on every key keep
+// their current relative order. Unlike inventory_sort this is a one-off
+// arrangement rather than a maintained view, so later adds are listed last
+// as in the unsorted order. Numeric keys are radix sorted in linear time;
+// with a name key, large inventories are merge sorted on every core.
+// Returns false for an invalid key list or if memory ran out; the display
+// still lists every item then, but may be partly sorted.
+bool inventory_sort_by_keys(Inventory *inv, const InventorySortKey *keys, int key_count);
+
+// Polled by long-running operations; returning true abandons the operation
+typedef bool (*InventoryCancelFunc)(void *data);
+
+// Writes the ids of items whose names contain query (all items for an empty
+// query) to ids, in display order. Returns the number found, or -1 if
+// cancelled is given and reports cancellation. It is polled every few
+// thousand rows throughout, including while the first search builds the
+// name index (a build cut short starts over next time). Apart from building
+// and using the name index, the search only reads the inventory, so it can
+// run on another thread while the owner only reads it too.
+int inventory_search(Inventory *inv, const char *query, int *ids, int max_results,
+                     InventoryCancelFunc cancelled, void *cancel_data);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef INVENTORY_MODEL_H
+#define INVENTORY_MODEL_H
+
+#include <gtk/gtk.h>
+#include "inventory.h"
+
+// GtkTreeModel that reads rows straight from an Inventory instead of keeping
+// a copy of every row. Rows follow the inventory's display order, or a list
+// of ids (e.g. search results) when a filter is set. Cell values are only
+// produced for the rows the view actually draws.
+//
+// Single-item changes are passed in with inventory_model_apply_change, which
+// signals just the affected row. After bulk changes (a reload, a new sort
+// order or filter), detach the model from its view and attach it again,
+// which resets the view in one step and invalidates outstanding iters.
+#define INVENTORY_TYPE_MODEL (inventory_model_get_type())
+G_DECLARE_FINAL_TYPE(InventoryModel, inventory_model, INVENTORY, MODEL, GObject)
+
+InventoryModel *inventory_model_new(Inventory *inv);
+
+// Shows every item again
+void inventory_model_clear_filter(InventoryModel *model);
+
+// Shows only the given ids, in order; the model takes ownership of ids
+// (allocated with g_new or malloc)
+void inventory_model_set_filter(InventoryModel *model, int *ids, int length);
+
+int inventory_model_row_count(InventoryModel *model);
+bool inventory_model_is_filtered(InventoryModel *model);
+
+// Signals the rows touched by a change the inventory just reported. While
+// filtered, updates and removals of listed ids are applied, but additions
+// are left to inventory_model_filter_append. INVENTORY_ITEMS_RESET signals
+// nothing; treat it as a bulk change.
+void inventory_model_apply_change(InventoryModel *model, const InventoryChange *change);
+
+// Adds an id to the end of the filter, e.g. a new item matching the search
+void inventory_model_filter_append(InventoryModel *model, int id);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef INVENTORY_PUBLISHER_H
+#define INVENTORY_PUBLISHER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "inventory.h"
+
+// Lets other threads read an inventory while its owner keeps editing it.
+// The owner (the writer) publishes immutable versions; readers pick up the
+// latest one without taking a lock, and a version stays intact for as long
+// as any reader that saw it is still inside. Neither side ever waits for
+// the other: a long report only delays freeing the versions it might use.
+//
+// A version is made of blocks of INVENTORY_CHUNK_ROWS rows (copy-on-write:
+// a block whose rows did not change since the last version is shared, not
+// copied) plus the display order, so publishing after a small edit costs
+// one block and a pass over the order.
+//
+// Old versions are freed by epoch: each reader records the epoch it entered
+// in, a replaced version is tagged with the epoch it was retired in, and it
+// is freed once every reader inside entered after that.
+
+#define INVENTORY_PUBLISHER_MAX_READERS 64
+
+// Rows [first, first + INVENTORY_CHUNK_ROWS) of the inventory's slots, with
+// their own copy of the names. Shared by every version it did not change in.
+typedef struct {
+    int refs;  // Versions using this chunk; only touched by the writer
+    int ids[INVENTORY_CHUNK_ROWS];
+    int quantities[INVENTORY_CHUNK_ROWS];
+    float prices[INVENTORY_CHUNK_ROWS];
+    int reorder_levels[INVENTORY_CHUNK_ROWS];
+    uint32_t name_offsets[INVENTORY_CHUNK_ROWS];  // Into names
+    uint8_t name_lengths[INVENTORY_CHUNK_ROWS];
+    char names[];  // NUL-terminated names
+} InventoryChunk;
+
+// Display positions [first, first + INVENTORY_CHUNK_ROWS) as slots
+typedef struct {
+    int refs;
+    int slots[INVENTORY_CHUNK_ROWS];
+} InventoryOrderChunk;
+
+// An immutable copy of the inventory as of one version. Everything a
+// reader needs is here; nothing points back into the live inventory.
+typedef struct InventoryVersion {
+    uint64_t version;  // Inventory version it was published at
+    int count;
+    int next_id;
+    InventoryTotals totals;
+    InventoryChunk **chunks;      // By slot / INVENTORY_CHUNK_ROWS
+    InventoryOrderChunk **order;  // By display position / INVENTORY_CHUNK_ROWS
+    struct InventoryVersion *next_retired;
+    uint64_t retired_epoch;
+} InventoryVersion;
+
+// One per reader, on its own cache line so readers do not slow each other
+typedef struct {
+    uint64_t epoch;  // Epoch the reader entered in, 0 while outside
+    int claimed;
+    char padding[64 - sizeof(uint64_t) - sizeof(int)];
+} InventoryReaderSlot;
+
+typedef struct {
+    InventoryVersion *current;  // Swapped atomically by the writer
+    uint64_t epoch;             // Starts at 1; bumped when a version is retired
+    InventoryReaderSlot readers[INVENTORY_PUBLISHER_MAX_READERS];
+    pthread_mutex_t write_lock;  // Serializes writers; readers never take it
+    InventoryVersion *retired;   // Replaced versions not yet freed
+    int retired_count;
+    uint64_t published_version;  // Inventory version of current
+} InventoryPublisher;
+
+// Starts with no version published
+void inventory_publisher_init(InventoryPublisher *publisher);
+
+// Frees every version; no reader may be inside
+void inventory_publisher_free(InventoryPublisher *publisher);
+
+// Publishes inv's current state, reusing the blocks that did not change.
+// Only one inventory may be published through a publisher. Also frees the
+// retired versions no reader can still see. Returns false, leaving the
+// previous version current, if memory ran out.
+bool inventory_publisher_publish(InventoryPublisher *publisher, Inventory *inv);
+
+// Frees the retired versions no reader can still see; returns how many are
+// still held back by readers
+int inventory_publisher_reclaim(InventoryPublisher *publisher);
+
+// Claims a reader slot for the calling thread; returns the reader, or -1 if
+// INVENTORY_PUBLISHER_MAX_READERS are taken. Lock-free.
+int inventory_publisher_register(InventoryPublisher *publisher);
+void inventory_publisher_unregister(InventoryPublisher *publisher, int reader);
+
+// Returns the latest version (NULL if none was published yet), which stays
+// valid until inventory_publisher_exit. Lock-free; may not be nested.
+const InventoryVersion *inventory_publisher_enter(InventoryPublisher *publisher, int reader);
+void inventory_publisher_exit(InventoryPublisher *publisher, int reader);
+
+// Read-only queries on a version; any number of threads may run them at once
+void inventory_version_read(const InventoryVersion *version, int position, InventoryItem *item);
+void inventory_version_read_slot(const InventoryVersion *version, int slot, InventoryItem *item);
+int inventory_version_slot_at(const InventoryVersion *version, int position);
+
+// Writes the ids of up to max_results items whose name contains query
+// (ignoring ASCII case), in display order, and returns how many
+int inventory_version_search(const InventoryVersion *version, const char *query, int *ids, int max_results);
+
+// Fills positions (count entries) with the display positions ordered by
+// keys, ties keeping display order. Returns false if memory ran out.
+bool inventory_version_sort(const InventoryVersion *version, const InventorySortKey *keys, int key_count,
+                            int *positions);
+
+#endif
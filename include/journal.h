@@ -0,0 +1,119 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "inventory.h"
+#include "inventory_publisher.h"
+#include "file_util.h"
+
+// Append-only log of item mutations made since the last checkpoint (a full
+// CSV save). Each add, update or delete costs one small append; a sync
+// thread writes and fsyncs whatever has accumulated in one go, so bursts of
+// edits share a single fsync (group commit).
+//
+// The file starts with a JournalHeader naming the CSV version the records
+// apply to, followed by records:
+//
+//   uint32  checksum   FNV-1a over the rest of the record
+//   uint16  type       JournalRecordType
+//   uint16  length     bytes of body that follow
+//   body               JournalItemBody + name, JournalReorderBody or
+//                      JournalCheckpointBody
+//
+// Records store resulting values rather than deltas, so replaying them on a
+// base that already contains some of them gives the same result.
+#define JOURNAL_MAGIC "SFJRNL\r\n"
+#define JOURNAL_VERSION 2
+
+// A checkpoint is due once this many bytes of records pile up
+#define JOURNAL_CHECKPOINT_SIZE (4 << 20)
+
+typedef enum {
+    JOURNAL_ADD = 1,
+    JOURNAL_UPDATE,
+    JOURNAL_DELETE,
+    JOURNAL_CHECKPOINT,  // Internal marker written while a checkpoint commits
+    JOURNAL_REORDER_LEVEL
+} JournalRecordType;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;  // 0x01020304 as stored by the writer
+    FileStamp base;       // CSV the records apply to; all zero if none existed
+} JournalHeader;
+
+typedef struct {
+    int32_t id;
+    int32_t quantity;
+    float price;
+    int32_t next_id;
+} JournalItemBody;
+
+typedef struct {
+    int32_t id;
+    int32_t reorder_level;
+} JournalReorderBody;
+
+// Says that the CSV identified by base already contains every record before
+// position (a byte offset into the records). It is made durable before that
+// CSV replaces the old one, so recovery works whichever one a crash leaves.
+typedef struct {
+    FileStamp base;
+    uint64_t position;
+} JournalCheckpointBody;
+
+typedef struct {
+    const char *filename;
+    const char *csv_filename;
+    const char *snapshot_filename;
+    FILE *file;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;     // New records or shutdown, for the sync thread
+    pthread_cond_t synced;   // A group commit finished
+    char *pending;           // Appended records not yet written
+    size_t pending_used;
+    size_t pending_capacity;
+    uint64_t appended;       // Record bytes ever appended
+    uint64_t committed;      // Record bytes ever written and synced
+    uint64_t dropped;        // Record bytes removed from the file by checkpoints
+    bool writing;            // The sync thread is writing outside the lock
+    bool failed;             // A write failed; later records are dropped
+    bool stopping;
+    pthread_t sync_thread;
+} Journal;
+
+// Opens (or creates) the journal, replaying its records into inv, which
+// should already hold the CSV or snapshot contents. Records written against
+// a CSV that has since been replaced by someone else are discarded.
+bool journal_open(Journal *journal, const char *filename, const char *csv_filename,
+                  const char *snapshot_filename, Inventory *inv);
+
+// Waits for pending records; no checkpoint may be running
+void journal_close(Journal *journal);
+
+// Logs a mutation just applied to inv; add, update and reorder level
+// records carry the item's current values. Returns without waiting for the disk.
+void journal_record(Journal *journal, JournalRecordType type, const Inventory *inv, int id);
+
+// Blocks until every record appended so far is on disk
+bool journal_sync(Journal *journal);
+
+bool journal_needs_checkpoint(Journal *journal);
+
+// Marks the end of the records appended so far; an inventory state taken at
+// the same moment reflects every record before it
+uint64_t journal_position(Journal *journal);
+
+// Saves inv, which must reflect every record before position, to the CSV and
+// snapshot, then drops those records. Records may keep being appended
+// meanwhile; only one checkpoint may run at a time.
+bool journal_checkpoint(Journal *journal, const Inventory *inv, uint64_t position);
+
+// The same from a published version, so the checkpoint can run on another
+// thread while the inventory keeps changing
+bool journal_checkpoint_version(Journal *journal, const InventoryVersion *version, uint64_t position);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LOAD_WORKER_H
+#define LOAD_WORKER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "inventory.h"
+#include "inventory_publisher.h"
+#include "journal.h"
+
+// Called on the worker thread once loading is over; loaded is false when
+// there was no inventory file to read
+typedef void (*LoadWorkerCallback)(bool loaded, void *user_data);
+
+// Background thread that loads the inventory at startup (snapshot or CSV,
+// then the journal replay), so the caller can show its window right away.
+// It then publishes the first version, so later publishes only copy what
+// changed. The inventory, publisher and journal belong to the worker until
+// the callback runs.
+typedef struct {
+    Inventory *inv;
+    InventoryPublisher *publisher;  // Optional
+    Journal *journal;
+    const char *csv_filename;
+    const char *snapshot_filename;
+    const char *journal_filename;
+    LoadWorkerCallback callback;
+    void *user_data;
+    pthread_t thread;
+    bool threaded;
+    bool loaded;
+    bool journal_opened;  // journal is open and must be closed by the caller
+} LoadWorker;
+
+// Falls back to loading on the calling thread, callback included, if the
+// thread cannot be started
+void load_worker_start(LoadWorker *worker, Inventory *inv, InventoryPublisher *publisher, Journal *journal,
+                       const char *csv_filename, const char *snapshot_filename, const char *journal_filename,
+                       LoadWorkerCallback callback, void *user_data);
+
+// Waits for the thread to exit; loaded and journal_opened are final afterwards
+void load_worker_join(LoadWorker *worker);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Per-operation latency histograms for the core entry points. Built in when
+// STOCKFLOW_METRICS is defined (make METRICS=1, the default); otherwise the
+// METRICS_* macros expand to nothing and the instrumented functions carry no
+// timing code at all. The query and dump functions always exist and report
+// empty histograms when metrics are compiled out.
+typedef enum {
+    METRIC_ADD,
+    METRIC_UPDATE,
+    METRIC_DELETE,
+    METRIC_FIND,
+    METRIC_SORT,
+    METRIC_SEARCH,
+    METRIC_LOAD,
+    METRIC_SAVE,
+    METRIC_OP_COUNT
+} MetricOp;
+
+// Log-linear buckets: each power of two of nanoseconds is split into
+// 2^METRICS_SUB_BUCKET_BITS equal buckets, so a bucket is never wider than
+// 12.5% of its value. Durations up to 2^40 ns (about 18 minutes) get their
+// own bucket; longer ones land in the last.
+#define METRICS_SUB_BUCKET_BITS 3
+#define METRICS_SUB_BUCKETS (1 << METRICS_SUB_BUCKET_BITS)
+#define METRICS_MAX_EXPONENT 40
+#define METRICS_BUCKET_COUNT ((METRICS_MAX_EXPONENT - METRICS_SUB_BUCKET_BITS + 2) * METRICS_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t bytes;  // Bytes read or written by file operations
+    uint64_t buckets[METRICS_BUCKET_COUNT];
+} MetricHistogram;
+
+#ifdef STOCKFLOW_METRICS
+#define METRICS_START(name) uint64_t name = metrics_now()
+#define METRICS_RECORD(op, start, bytes) metrics_record((op), (start), (bytes))
+#else
+#define METRICS_START(name)
+#define METRICS_RECORD(op, start, bytes) ((void)0)
+#endif
+
+// Monotonic clock in nanoseconds
+uint64_t metrics_now(void);
+
+// Adds the time since start to op's histogram. Lock-free; safe from any thread.
+void metrics_record(MetricOp op, uint64_t start, uint64_t bytes);
+
+bool metrics_enabled(void);
+const char *metrics_op_name(MetricOp op);
+
+// Copies op's histogram. Counters are read one by one while other threads
+// may be recording, so the totals can be off by the operations in flight.
+void metrics_get(MetricOp op, MetricHistogram *histogram);
+void metrics_reset(void);
+
+// Upper bound of the bucket holding the p-th fraction (0..1) of samples
+uint64_t metrics_percentile(const MetricHistogram *histogram, double p);
+
+// A table of count, mean, p50, p99, max and bytes per operation, or the same
+// plus every non-empty bucket as JSON
+void metrics_dump_text(FILE *out);
+void metrics_dump_json(FILE *out);
+
+// Replaces filename atomically with a dump; JSON if the name ends in ".json"
+bool metrics_write_file(const char *filename);
+
+#endif
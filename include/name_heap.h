@@ -0,0 +1,37 @@
+#ifndef NAME_HEAP_H
+#define NAME_HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Append-only arena of NUL-terminated names addressed by 32-bit offsets.
+// Replaced or deleted names become garbage until the owner compacts.
+typedef struct {
+    char *data;
+    size_t used;
+    size_t capacity;
+    size_t garbage;  // Bytes held by names that are no longer referenced
+} NameHeap;
+
+void name_heap_init(NameHeap *heap);
+void name_heap_free(NameHeap *heap);
+void name_heap_clear(NameHeap *heap);
+bool name_heap_reserve(NameHeap *heap, size_t min_capacity);
+
+// Replaces the contents with size bytes of packed names, garbage of which
+// are no longer referenced
+bool name_heap_assign(NameHeap *heap, const char *data, size_t size, size_t garbage);
+
+// Copies length bytes of name plus a NUL; returns false if the heap cannot grow
+bool name_heap_append(NameHeap *heap, const char *name, size_t length, uint32_t *offset);
+void name_heap_release(NameHeap *heap, size_t length);
+
+// True once at least half the heap is garbage
+bool name_heap_needs_compaction(const NameHeap *heap);
+
+// Rewrites the count live names (offsets[i], lengths[i]) contiguously and
+// updates offsets in place
+bool name_heap_compact(NameHeap *heap, uint32_t *offsets, const uint8_t *lengths, int count);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <stdbool.h>
+
+// Orders two values (typically row slots) through whatever context
+// describes them: negative, zero or positive as for qsort
+typedef int (*ParallelSortCompare)(const void *context, int a, int b);
+
+// Inputs shorter than this are sorted on the calling thread
+#define PARALLEL_SORT_MIN_PARALLEL 65536
+#define PARALLEL_SORT_MAX_THREADS 64
+
+// Stable merge sort of n ints. Large inputs are cut into one run per core
+// (at most PARALLEL_SORT_MAX_THREADS), and a pool of threads started for the
+// call sorts the runs and then merges them pairwise, every thread taking an
+// equal share of each merge round. compare must be safe to call from
+// several threads at once. Returns false, leaving values untouched, if the
+// scratch buffer cannot be allocated.
+bool parallel_sort(int *values, int n, ParallelSortCompare compare, const void *context);
+
+// Threads a sort of n values would use, for benchmarks and diagnostics
+int parallel_sort_thread_count(int n);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Order-preserving transforms from numeric sort keys to unsigned integers:
+// a before b exactly when key(a) < key(b). Descending order is the same
+// transform with the bits inverted, so no reversal pass is needed.
+static inline uint32_t radix_key_int(int value, bool ascending) {
+    uint32_t key = (uint32_t)value ^ 0x80000000u;
+    return ascending ? key : ~key;
+}
+
+// Positive floats already order like their bits; negative ones have the
+// magnitude bits reversed. -0.0 is folded into 0.0, which compares equal.
+static inline uint32_t radix_key_float(float value, bool ascending) {
+    uint32_t bits = 0;
+    if (value != 0.0f) {
+        memcpy(&bits, &value, sizeof(bits));
+    }
+    uint32_t key = (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
+    return ascending ? key : ~key;
+}
+
+// Stable LSD radix sort of n (key, value) pairs by key, 11 bits per pass.
+// Digits that are the same for every key (the high bits of small ids or
+// quantities, say) are detected from the histograms and skipped, so most
+// sorts take two to four passes over the data. Returns false, leaving the
+// arrays untouched, if the scratch buffers cannot be allocated.
+bool radix_sort_pairs(uint64_t *keys, int *values, int n);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef SAVE_WORKER_H
+#define SAVE_WORKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "inventory.h"
+#include "inventory_publisher.h"
+#include "journal.h"
+
+// Called on the worker thread when a save finishes; version is the
+// inventory version that was written
+typedef void (*SaveWorkerCallback)(bool ok, uint64_t version, void *user_data);
+
+// Background thread that writes inventory saves. A request publishes the
+// inventory on the caller's thread, which copies only the blocks changed
+// since the last version, and the worker writes that version while the
+// caller keeps mutating the inventory. With a journal, a save is a journal
+// checkpoint; otherwise the CSV and snapshot are written directly.
+typedef struct {
+    InventoryPublisher *publisher;
+    int reader;        // Entered by a request, left by the worker once written
+    Journal *journal;  // Optional
+    const char *csv_filename;
+    const char *snapshot_filename;
+    SaveWorkerCallback callback;
+    void *user_data;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;  // A request or shutdown, for the worker
+    pthread_cond_t idle;  // A save finished
+    const InventoryVersion *version;  // State being written
+    uint64_t position;    // Journal position matching version
+    bool requested;
+    bool busy;            // A request is queued or being written
+    bool stopping;
+} SaveWorker;
+
+// The publisher must be the only one inv is published through. Returns
+// false if the thread cannot be started or no reader slot is free.
+bool save_worker_start(SaveWorker *worker, InventoryPublisher *publisher, Journal *journal,
+                       const char *csv_filename, const char *snapshot_filename,
+                       SaveWorkerCallback callback, void *user_data);
+
+// Finishes the save in progress, if any, then stops the thread
+void save_worker_stop(SaveWorker *worker);
+
+// Queues a save of inv's current state. Returns false if a save is still
+// running or inv could not be published.
+bool save_worker_request(SaveWorker *worker, Inventory *inv);
+
+bool save_worker_busy(SaveWorker *worker);
+
+// Blocks until no save is running
+void save_worker_wait(SaveWorker *worker);
+
+#endif
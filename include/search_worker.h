@@ -0,0 +1,54 @@
+#ifndef SEARCH_WORKER_H
+#define SEARCH_WORKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "inventory.h"
+
+// Called on the worker thread with the result of a request: ids (malloc'd,
+// owned by the callee) in display order, the request's generation and the
+// inventory version the search saw
+typedef void (*SearchWorkerCallback)(int *ids, int count, uint64_t generation, uint64_t version,
+                                     void *user_data);
+
+// Background thread that runs name searches over an inventory. Only the
+// latest request matters: a new request or a cancel abandons the search in
+// flight. The worker reads the inventory while searching, so the owner must
+// bracket every change to it with search_worker_lock_inventory and
+// search_worker_unlock_inventory; a search interrupted that way is rerun
+// once the inventory is unlocked.
+typedef struct {
+    Inventory *inv;
+    SearchWorkerCallback callback;
+    void *user_data;
+    pthread_t thread;
+    pthread_mutex_t lock;            // Protects the fields below
+    pthread_cond_t wake;             // A request, an unlock or shutdown, for the worker
+    pthread_mutex_t inventory_lock;  // Held by whoever is using the inventory
+    char *query;                     // Pending request, or NULL
+    uint64_t generation;             // Bumped by every request and cancel
+    int writers;                     // Owner threads waiting for or holding inventory_lock
+    bool stopping;
+} SearchWorker;
+
+bool search_worker_start(SearchWorker *worker, Inventory *inv, SearchWorkerCallback callback, void *user_data);
+
+// Abandons any search, then stops the thread
+void search_worker_stop(SearchWorker *worker);
+
+// Queues a search for query, replacing any pending or running one; returns
+// the generation its result will carry, or 0 if memory ran out
+uint64_t search_worker_request(SearchWorker *worker, const char *query);
+
+// Abandons the pending or running search without starting another
+void search_worker_cancel(SearchWorker *worker);
+
+// Interrupts the running search, if any, and takes the inventory
+void search_worker_lock_inventory(SearchWorker *worker);
+
+// Hands the inventory back; its display order must hold no deleted entries
+// (see inventory_search)
+void search_worker_unlock_inventory(SearchWorker *worker);
+
+#endif
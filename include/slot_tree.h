@@ -0,0 +1,59 @@
+#ifndef SLOT_TREE_H
+#define SLOT_TREE_H
+
+#include <stdbool.h>
+
+// Counted B+tree of slots kept in an order the caller defines through
+// compare (negative, zero or positive as for qsort; zero only for the same
+// slot). Every inner node records how many slots lie under each child, so
+// inserting, removing, and finding a slot's position or the slot at a
+// position all take O(log n), and no change moves more than one node's
+// worth of entries.
+typedef int (*SlotTreeCompare)(const void *context, int a, int b);
+
+// A leaf holds this many slots, an inner node this many children; both come
+// to about 1 KiB, so one node size serves for either
+#define SLOT_TREE_LEAF_SLOTS 256
+#define SLOT_TREE_INNER_CHILDREN 64
+
+typedef struct SlotTreeNode SlotTreeNode;
+
+typedef struct {
+    SlotTreeNode *root;   // NULL while empty
+    int height;           // Inner levels above the leaves
+    int length;
+    SlotTreeNode *spare;  // Nodes set aside by slot_tree_reserve
+    int spare_count;
+} SlotTree;
+
+void slot_tree_init(SlotTree *tree);
+void slot_tree_free(SlotTree *tree);
+
+// Replaces the contents with n slots already in order, in O(n). On failure
+// the tree is left empty.
+bool slot_tree_assign(SlotTree *tree, const int *slots, int n);
+
+// Sets aside enough nodes that the next inserts insertions cannot run out of
+// memory
+bool slot_tree_reserve(SlotTree *tree, int inserts);
+
+// Returns false, leaving the tree as it was, if memory ran out
+bool slot_tree_insert(SlotTree *tree, int slot, SlotTreeCompare compare, const void *context);
+
+// Return false if slot is not in the tree
+bool slot_tree_remove(SlotTree *tree, int slot, SlotTreeCompare compare, const void *context);
+
+// Points the entry for from_slot at to_slot, which must sort in the same
+// place; compare is only called while from_slot still describes the row
+bool slot_tree_replace(SlotTree *tree, int from_slot, int to_slot, SlotTreeCompare compare, const void *context);
+
+// Position of slot, or -1 if it is not in the tree
+int slot_tree_rank(const SlotTree *tree, int slot, SlotTreeCompare compare, const void *context);
+
+// Slot at position, which must be below length
+int slot_tree_select(const SlotTree *tree, int position);
+
+// Copies the count slots from position on to slots; only reads the tree
+void slot_tree_read(const SlotTree *tree, int position, int count, int *slots);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inventory.h"
+#include "inventory_publisher.h"
+#include "file_util.h"
+
+// Binary snapshot of an inventory kept next to its CSV file so startup can
+// skip text parsing. Layout (native byte order, every section 8-byte aligned):
+//
+//   SnapshotHeader
+//   int32   ids[count]
+//   int32   quantities[count]
+//   float   prices[count]
+//   int32   reorder_levels[count]
+//   uint32  name_offsets[count]   into the string table
+//   uint8   name_lengths[count]
+//   char    names[names_size]     NUL-terminated names
+//
+// Rows are in display order. The header records the FileStamp of the CSV it
+// mirrors, and a checksum covers everything after it.
+#define SNAPSHOT_MAGIC "SFSNAP\r\n"
+#define SNAPSHOT_VERSION 3
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;    // 0x01020304 as stored by the writer
+    FileStamp source;       // The CSV when written
+    int32_t count;
+    int32_t next_id;
+    uint64_t names_size;
+    uint64_t checksum;
+} SnapshotHeader;
+
+// Writes the snapshot atomically, stamped with source_filename's current
+// stamp (call it right after saving or loading that file)
+bool snapshot_save(const Inventory *inv, const char *filename, const char *source_filename);
+
+// The same for a published version, from any thread
+bool snapshot_save_version(const InventoryVersion *version, const char *filename, const char *source_filename);
+
+// Loads the snapshot only if it is intact and still matches source_filename's
+// stamp; returns false otherwise
+bool snapshot_load(Inventory *inv, const char *filename, const char *source_filename);
+
+// Loads csv_filename, using its snapshot when current and refreshing the
+// snapshot after parsing the CSV when not
+bool load_inventory_with_snapshot(Inventory *inv, const char *csv_filename, const char *snapshot_filename);
+
+#endif
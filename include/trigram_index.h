@@ -0,0 +1,36 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Inverted index from each lowercase 3-byte substring of an item name to
+// the ids of the items containing it. Posting lists are kept sorted by id.
+typedef struct {
+    uint32_t trigram;  // Packed bytes; 0 marks an empty bucket (names hold no NULs)
+    int *ids;
+    int length;
+    int capacity;
+} TrigramPosting;
+
+typedef struct {
+    TrigramPosting *buckets;
+    int capacity;  // Always zero or a power of two
+    int count;
+    bool built;    // Set by the owner once every item has been added
+} TrigramIndex;
+
+#define TRIGRAM_MIN_QUERY_LENGTH 3
+
+void trigram_index_init(TrigramIndex *index);
+void trigram_index_free(TrigramIndex *index);
+bool trigram_index_add(TrigramIndex *index, int id, const char *name);
+void trigram_index_remove(TrigramIndex *index, int id, const char *name);
+
+// Ids of items whose names contain every trigram of query, ascending.
+// Candidates still need a substring check. Returns the number of ids and a
+// malloc'd array in *ids, or -1 if the query is too short to use the index
+// or memory ran out.
+int trigram_index_query(const TrigramIndex *index, const char *query, int **ids);
+
+#endif
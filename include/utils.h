@@ -2,24 +2,33 @@
 #define UTILS_H
 
 #include <stdbool.h>
-#include <gtk/gtk.h>
+#include <stddef.h>
 #include "inventory.h"
+#include "csv_io.h"
 
 // Input validation
 bool validate_name(const char *name);
 bool validate_quantity(const char *quantity_str, int *quantity);
 bool validate_price(const char *price_str, float *price);
 
-// File I/O
-bool save_inventory_to_file(const Inventory *inv, const char *filename);
-bool load_inventory_from_file(Inventory *inv, const char *filename);
-
 // String utilities
 void trim_string(char *str);
 bool string_contains_ignore_case(const char *haystack, const char *needle);
 
-// Error handling
-void show_error_dialog(GtkWidget *parent, const char *message);
-void show_info_dialog(GtkWidget *parent, const char *message);
+// Writes cents as a decimal amount with two places, e.g. -1234 -> "-12.34"
+void format_cents(char *buffer, size_t size, int64_t cents);
+
+// Case-insensitive (ASCII) substring matcher prepared once per query.
+// Matching folds case on the fly and never allocates; the needle must
+// outlive the matcher.
+typedef struct {
+    const char *needle;
+    size_t length;
+    unsigned char first;  // Lowercase first and last needle bytes, used
+    unsigned char last;   // to filter candidate positions
+} StringMatcher;
+
+void string_matcher_init(StringMatcher *matcher, const char *needle);
+bool string_matcher_find(const StringMatcher *matcher, const char *haystack, size_t haystack_length);
 
 #endif
\ No newline at end of file
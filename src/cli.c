@@ -0,0 +1,654 @@
+// Headless command-line front end for batch jobs. It works on the same files
+// as the GUI (CSV, snapshot and journal) through libstockflow, without GTK.
+#define _POSIX_C_SOURCE 200809L  // For strdup
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "inventory.h"
+#include "utils.h"
+#include "csv_io.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "metrics.h"
+
+#define CLI_DEFAULT_FILE "inventory.csv"
+#define CLI_MAX_LINE 1024
+#define CLI_MAX_FIELDS 5
+
+static void cli_usage(FILE *out) {
+    fprintf(out,
+        "Usage: stockflow [-f FILE] COMMAND [ARGS]\n"
+        "\n"
+        "FILE is the inventory CSV (default " CLI_DEFAULT_FILE "); its snapshot and\n"
+        "journal sit next to it, as for the GUI.\n"
+        "\n"
+        "Commands:\n"
+        "  import SOURCE.csv             Add every row of SOURCE as a new item\n"
+        "  export DEST.csv               Write the inventory to DEST\n"
+        "  query [TEXT] [--sort KEYS] [--desc] [--limit N]\n"
+        "                                Print items whose name contains TEXT as CSV;\n"
+        "                                KEYS is a comma-separated list of id, name,\n"
+        "                                quantity or price, each optionally followed\n"
+        "                                by :asc or :desc; later keys break ties\n"
+        "  add NAME QUANTITY PRICE       Add an item and print its id\n"
+        "  update ID NAME QUANTITY PRICE Replace an item's fields\n"
+        "  delete ID...                  Delete items\n"
+        "  apply OPS.csv|-               Apply operations, one per line:\n"
+        "                                  add,NAME,QUANTITY,PRICE[,REORDER_LEVEL]\n"
+        "                                  update,ID,NAME,QUANTITY,PRICE\n"
+        "                                  delete,ID\n"
+        "                                  adjust,ID,DELTA\n"
+        "                                Nothing is saved if any line fails.\n"
+        "  stats                         Print item and unit counts, stock value and\n"
+        "                                low-stock counts\n"
+        "  reorder-level ID LEVEL        Report the item once it has fewer than LEVEL\n"
+        "                                units; 0 turns this off\n"
+        "  reorder [--limit N]           Print items below their reorder level,\n"
+        "                                largest shortfall first\n");
+}
+
+// An open inventory: the CSV (or its snapshot) plus any journaled edits
+typedef struct {
+    Inventory inv;
+    Journal journal;
+    bool journaled;  // The journal is open; saving checkpoints it
+    char *csv_filename;
+    char *snapshot_filename;
+    char *journal_filename;
+} CliSession;
+
+// "dir/inventory.csv" -> "dir/inventory" + suffix, matching the GUI's names
+static char *cli_sibling_filename(const char *csv_filename, const char *suffix) {
+    size_t length = strlen(csv_filename);
+    if (length >= 4 && strcmp(csv_filename + length - 4, ".csv") == 0) {
+        length -= 4;
+    }
+    
+    char *filename = malloc(length + strlen(suffix) + 1);
+    if (filename) {
+        memcpy(filename, csv_filename, length);
+        strcpy(filename + length, suffix);
+    }
+    return filename;
+}
+
+static void cli_close(CliSession *session) {
+    if (session->journaled) {
+        journal_close(&session->journal);
+    }
+    inventory_free(&session->inv);
+    free(session->csv_filename);
+    free(session->snapshot_filename);
+    free(session->journal_filename);
+}
+
+// A missing CSV is an empty inventory, so the first add can create it; one
+// that exists but cannot be loaded is an error
+static bool cli_open(CliSession *session, const char *csv_filename) {
+    inventory_init(&session->inv);
+    session->journaled = false;
+    session->csv_filename = cli_sibling_filename(csv_filename, ".csv");
+    session->snapshot_filename = cli_sibling_filename(csv_filename, ".snapshot");
+    session->journal_filename = cli_sibling_filename(csv_filename, ".journal");
+    if (!session->csv_filename || !session->snapshot_filename || !session->journal_filename) {
+        fprintf(stderr, "stockflow: out of memory\n");
+        cli_close(session);
+        return false;
+    }
+    
+    FileStamp csv_stamp;
+    if (!load_inventory_with_snapshot(&session->inv, session->csv_filename, session->snapshot_filename) &&
+        file_stamp_get(session->csv_filename, &csv_stamp)) {
+        // Carrying on with what did load would let the next save truncate the file
+        fprintf(stderr, "stockflow: cannot load %s\n", session->csv_filename);
+        cli_close(session);
+        return false;
+    }
+    session->journaled = journal_open(&session->journal, session->journal_filename, session->csv_filename,
+                                      session->snapshot_filename, &session->inv);
+    if (!session->journaled) {
+        fprintf(stderr, "stockflow: warning: cannot open %s; unsaved GUI edits are not included\n",
+                session->journal_filename);
+    }
+    return true;
+}
+
+// Writes the CSV and snapshot once, however many edits were made; with a
+// journal this is a checkpoint, which also trims it
+static bool cli_save(CliSession *session) {
+    bool saved;
+    if (session->journaled) {
+        saved = journal_checkpoint(&session->journal, &session->inv, journal_position(&session->journal));
+    } else {
+        saved = save_inventory_to_file(&session->inv, session->csv_filename);
+        if (saved) {
+            snapshot_save(&session->inv, session->snapshot_filename, session->csv_filename);
+        }
+    }
+    
+    if (!saved) {
+        fprintf(stderr, "stockflow: cannot save %s\n", session->csv_filename);
+    }
+    return saved;
+}
+
+static bool cli_parse_id(const char *text, int *id) {
+    return validate_quantity(text, id) && *id > 0;
+}
+
+static bool cli_add(Inventory *inv, const char *name, const char *quantity_str, const char *price_str, int *id) {
+    int quantity;
+    float price;
+    if (!validate_name(name) || !validate_quantity(quantity_str, &quantity) || !validate_price(price_str, &price)) {
+        fprintf(stderr, "stockflow: invalid item: %s,%s,%s\n", name, quantity_str, price_str);
+        return false;
+    }
+    
+    *id = inventory_add_item(inv, name, quantity, price);
+    if (*id == -1) {
+        fprintf(stderr, "stockflow: out of memory\n");
+        return false;
+    }
+    return true;
+}
+
+static bool cli_update(Inventory *inv, const char *id_str, const char *name, const char *quantity_str,
+                       const char *price_str) {
+    int id, quantity;
+    float price;
+    if (!cli_parse_id(id_str, &id) || !validate_name(name) || !validate_quantity(quantity_str, &quantity) ||
+        !validate_price(price_str, &price)) {
+        fprintf(stderr, "stockflow: invalid update: %s,%s,%s,%s\n", id_str, name, quantity_str, price_str);
+        return false;
+    }
+    if (!inventory_update_item(inv, id, name, quantity, price)) {
+        fprintf(stderr, "stockflow: no item with id %d\n", id);
+        return false;
+    }
+    return true;
+}
+
+static bool cli_set_reorder_level(Inventory *inv, const char *id_str, const char *level_str) {
+    int id, level;
+    if (!cli_parse_id(id_str, &id) || !validate_quantity(level_str, &level)) {
+        fprintf(stderr, "stockflow: invalid reorder level: %s,%s\n", id_str, level_str);
+        return false;
+    }
+    if (!inventory_set_reorder_level(inv, id, level)) {
+        fprintf(stderr, "stockflow: no item with id %d\n", id);
+        return false;
+    }
+    return true;
+}
+
+static bool cli_delete(Inventory *inv, const char *id_str) {
+    int id;
+    if (!cli_parse_id(id_str, &id)) {
+        fprintf(stderr, "stockflow: invalid id: %s\n", id_str);
+        return false;
+    }
+    if (!inventory_delete_item(inv, id)) {
+        fprintf(stderr, "stockflow: no item with id %d\n", id);
+        return false;
+    }
+    return true;
+}
+
+// Names are quoted with quotes doubled, as in the CSV files
+static void cli_print_name(FILE *out, const char *name) {
+    fputc('"', out);
+    for (const char *p = name; *p; p++) {
+        if (*p == '"') {
+            fputc('"', out);
+        }
+        fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+// Same row format as the CSV files
+static void cli_print_item(FILE *out, const InventoryItem *item) {
+    fprintf(out, "%d,", item->id);
+    cli_print_name(out, item->name);
+    fprintf(out, ",%d,%.2f,%d\n", item->quantity, item->price, item->reorder_level);
+}
+
+static bool cli_parse_sort_criteria(const char *key, size_t length, SortCriteria *criteria) {
+    static const char *const names[SORT_CRITERIA_COUNT] = {"id", "name", "quantity", "price"};
+    for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+        if (strlen(names[c]) == length && strncmp(key, names[c], length) == 0) {
+            *criteria = (SortCriteria)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "quantity,name:desc,id" -> keys; a key without :asc or :desc gets the
+// default direction
+static int cli_parse_sort_keys(const char *spec, bool ascending, InventorySortKey *keys) {
+    int count = 0;
+    const char *p = spec;
+    while (count < INVENTORY_MAX_SORT_KEYS) {
+        size_t length = strcspn(p, ",:");
+        keys[count].ascending = ascending;
+        if (!cli_parse_sort_criteria(p, length, &keys[count].criteria)) {
+            return -1;
+        }
+        p += length;
+        if (*p == ':') {
+            size_t direction_length = strcspn(++p, ",");
+            if (direction_length == 3 && strncmp(p, "asc", 3) == 0) {
+                keys[count].ascending = true;
+            } else if (direction_length == 4 && strncmp(p, "desc", 4) == 0) {
+                keys[count].ascending = false;
+            } else {
+                return -1;
+            }
+            p += direction_length;
+        }
+        count++;
+        if (*p != ',') {
+            return *p == '\0' ? count : -1;
+        }
+        p++;
+    }
+    return -1;
+}
+
+static int cli_query(CliSession *session, int argc, char **argv) {
+    const char *text = "";
+    const char *sort_spec = NULL;
+    bool ascending = true;
+    long limit = -1;
+    
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc) {
+            sort_spec = argv[++i];
+        } else if (strcmp(argv[i], "--desc") == 0) {
+            ascending = false;
+        } else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = strtol(argv[++i], NULL, 10);
+        } else {
+            text = argv[i];
+        }
+    }
+    
+    InventorySortKey keys[INVENTORY_MAX_SORT_KEYS] = {{SORT_BY_ID, ascending}};
+    int key_count = sort_spec ? cli_parse_sort_keys(sort_spec, ascending, keys) : 1;
+    if (key_count == -1) {
+        fprintf(stderr, "stockflow: invalid sort keys: %s\n", sort_spec);
+        return 2;
+    }
+    
+    // One key uses the maintained sort view; several are a one-off stable sort
+    Inventory *inv = &session->inv;
+    if (key_count == 1 && (sort_spec || !ascending)) {
+        inventory_sort(inv, keys[0].criteria, keys[0].ascending);
+    } else if (key_count > 1 && !inventory_sort_by_keys(inv, keys, key_count)) {
+        fprintf(stderr, "stockflow: out of memory\n");
+        return 1;
+    }
+    
+    int *ids = malloc((size_t)(inv->count > 0 ? inv->count : 1) * sizeof(int));
+    if (!ids) {
+        fprintf(stderr, "stockflow: out of memory\n");
+        return 1;
+    }
+    int max_results = (limit >= 0 && limit < inv->count) ? (int)limit : inv->count;
+    int count = inventory_search(inv, text, ids, max_results, NULL, NULL);
+    
+    printf("ID,Name,Quantity,Price,Reorder Level\n");
+    for (int i = 0; i < count; i++) {
+        InventoryItem item;
+        inventory_get_item(inv, ids[i], &item);
+        cli_print_item(stdout, &item);
+    }
+    
+    free(ids);
+    return 0;
+}
+
+static int cli_import(CliSession *session, const char *source_filename) {
+    Inventory source;
+    inventory_init(&source);
+    if (!load_inventory_from_file(&source, source_filename)) {
+        fprintf(stderr, "stockflow: cannot read %s\n", source_filename);
+        inventory_free(&source);
+        return 1;
+    }
+    
+    // Imported rows get fresh ids, so they cannot collide with existing items.
+    // Names point into source, which outlives the batch.
+    InventoryOp *ops = malloc((size_t)(source.count > 0 ? source.count : 1) * sizeof(InventoryOp));
+    InventoryOpResult *results = malloc((size_t)(source.count > 0 ? source.count : 1) * sizeof(InventoryOpResult));
+    bool ok = ops && results;
+    for (int i = 0; ok && i < source.count; i++) {
+        int slot = inventory_slot_at(&source, i);
+        ops[i] = (InventoryOp){INVENTORY_OP_ADD, 0, inventory_name_at(&source, slot), source.quantities[slot],
+                               source.prices[slot], source.reorder_levels[slot]};
+    }
+    ok = ok && inventory_apply_batch(&session->inv, ops, source.count, results);
+    free(ops);
+    free(results);
+    if (!ok) {
+        fprintf(stderr, "stockflow: cannot import %s\n", source_filename);
+        inventory_free(&source);
+        return 1;
+    }
+    
+    int imported = source.count;
+    inventory_free(&source);
+    if (!cli_save(session)) {
+        return 1;
+    }
+    printf("Imported %d items\n", imported);
+    return 0;
+}
+
+// Splits one line into comma-separated fields in place. Fields may be
+// quoted, with "" standing for a quote, as in the inventory CSV files.
+static int cli_split_fields(char *line, char **fields, int max_fields) {
+    int count = 0;
+    char *p = line;
+    
+    while (count < max_fields) {
+        char *out = p;
+        fields[count++] = out;
+        if (*p == '"') {
+            p++;
+            while (*p && !(*p == '"' && p[1] != '"')) {
+                if (*p == '"') {
+                    p++;
+                }
+                *out++ = *p++;
+            }
+            if (*p == '"') {
+                p++;
+            }
+        }
+        while (*p && *p != ',') {
+            *out++ = *p++;
+        }
+        
+        bool more = *p == ',';
+        *out = '\0';
+        if (!more) {
+            break;
+        }
+        p++;
+    }
+    return count;
+}
+
+// Parses one operation line into op, copying the name; reports bad lines
+static bool cli_parse_op(char **fields, int count, InventoryOp *op) {
+    memset(op, 0, sizeof(*op));
+    const char *name = NULL;
+    bool valid;
+    if (strcmp(fields[0], "add") == 0 && (count == 4 || count == 5)) {
+        op->type = INVENTORY_OP_ADD;
+        name = fields[1];
+        valid = validate_name(name) && validate_quantity(fields[2], &op->quantity) &&
+                validate_price(fields[3], &op->price) &&
+                (count == 4 || validate_quantity(fields[4], &op->reorder_level));
+    } else if (strcmp(fields[0], "update") == 0 && count == 5) {
+        op->type = INVENTORY_OP_UPDATE;
+        name = fields[2];
+        valid = cli_parse_id(fields[1], &op->id) && validate_name(name) &&
+                validate_quantity(fields[3], &op->quantity) && validate_price(fields[4], &op->price);
+    } else if (strcmp(fields[0], "delete") == 0 && count == 2) {
+        op->type = INVENTORY_OP_DELETE;
+        valid = cli_parse_id(fields[1], &op->id);
+    } else if (strcmp(fields[0], "adjust") == 0 && count == 3) {
+        op->type = INVENTORY_OP_ADJUST_QUANTITY;
+        char *endptr;
+        long delta = strtol(fields[2], &endptr, 10);
+        valid = cli_parse_id(fields[1], &op->id) && fields[2][0] != '\0' && *endptr == '\0' &&
+                delta >= -INT_MAX && delta <= INT_MAX;
+        op->quantity = (int)delta;
+    } else {
+        fprintf(stderr, "stockflow: unknown operation\n");
+        return false;
+    }
+    
+    if (!valid) {
+        fprintf(stderr, "stockflow: invalid %s operation\n", fields[0]);
+        return false;
+    }
+    if (name && !(op->name = strdup(name))) {
+        fprintf(stderr, "stockflow: out of memory\n");
+        return false;
+    }
+    return true;
+}
+
+static const char *cli_op_status_message(InventoryOpStatus status) {
+    switch (status) {
+        case INVENTORY_OP_INVALID: return "invalid item";
+        case INVENTORY_OP_NOT_FOUND: return "no item with that id";
+        case INVENTORY_OP_OUT_OF_RANGE: return "quantity would go out of range";
+        case INVENTORY_OP_NO_MEMORY: return "out of memory";
+        default: return "not applied";
+    }
+}
+
+// Reads every line first and applies them as one batch, so the inventory is
+// checked once and its sort views are merged once, however long the file
+static int cli_apply(CliSession *session, const char *ops_filename) {
+    bool from_stdin = strcmp(ops_filename, "-") == 0;
+    FILE *in = from_stdin ? stdin : fopen(ops_filename, "r");
+    if (!in) {
+        fprintf(stderr, "stockflow: cannot read %s\n", ops_filename);
+        return 1;
+    }
+    
+    InventoryOp *ops = NULL;
+    int *line_numbers = NULL;  // Source line of each operation, for errors
+    int count = 0;
+    int capacity = 0;
+    char line[CLI_MAX_LINE];
+    int line_number = 0;
+    bool ok = true;
+    
+    while (ok && fgets(line, sizeof(line), in)) {
+        line_number++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 64;
+            InventoryOp *new_ops = realloc(ops, (size_t)new_capacity * sizeof(InventoryOp));
+            if (new_ops) {
+                ops = new_ops;
+            }
+            int *new_line_numbers = realloc(line_numbers, (size_t)new_capacity * sizeof(int));
+            if (new_line_numbers) {
+                line_numbers = new_line_numbers;
+            }
+            if (!new_ops || !new_line_numbers) {
+                fprintf(stderr, "stockflow: out of memory\n");
+                ok = false;
+                break;
+            }
+            capacity = new_capacity;
+        }
+        
+        char *fields[CLI_MAX_FIELDS];
+        int field_count = cli_split_fields(line, fields, CLI_MAX_FIELDS);
+        if (cli_parse_op(fields, field_count, &ops[count])) {
+            line_numbers[count++] = line_number;
+        } else {
+            fprintf(stderr, "stockflow: %s:%d: operation failed; nothing was saved\n", ops_filename, line_number);
+            ok = false;
+        }
+    }
+    if (!from_stdin) {
+        fclose(in);
+    }
+    
+    InventoryOpResult *results = ok ? malloc((size_t)(count > 0 ? count : 1) * sizeof(InventoryOpResult)) : NULL;
+    if (ok && !results) {
+        fprintf(stderr, "stockflow: out of memory\n");
+        ok = false;
+    }
+    if (ok && !inventory_apply_batch(&session->inv, ops, count, results)) {
+        for (int i = 0; i < count; i++) {
+            if (results[i].status != INVENTORY_OP_OK && results[i].status != INVENTORY_OP_SKIPPED) {
+                fprintf(stderr, "stockflow: %s:%d: %s; nothing was saved\n", ops_filename, line_numbers[i],
+                        cli_op_status_message(results[i].status));
+            }
+        }
+        ok = false;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        free((char *)ops[i].name);
+    }
+    free(ops);
+    free(line_numbers);
+    free(results);
+    if (!ok || !cli_save(session)) {
+        return 1;
+    }
+    printf("Applied %d operations\n", count);
+    return 0;
+}
+
+static int cli_stats(CliSession *session) {
+    Inventory *inv = &session->inv;
+    char value[32];
+    format_cents(value, sizeof(value), inventory_stock_value_cents(inv));
+    
+    // All read from the running totals, without a pass over the items
+    static const int limits[INVENTORY_LOW_STOCK_LIMIT_COUNT] = INVENTORY_LOW_STOCK_LIMITS;
+    printf("items,%d\n", inv->count);
+    printf("units,%lld\n", (long long)inventory_total_units(inv));
+    printf("stock_value,%s\n", value);
+    for (int i = 0; i < INVENTORY_LOW_STOCK_LIMIT_COUNT; i++) {
+        printf("low_stock_below_%d,%d\n", limits[i], inventory_count_low_stock(inv, limits[i]));
+    }
+    return 0;
+}
+
+// Items below their reorder level, read off the top of the reorder heap
+static int cli_reorder(CliSession *session, int argc, char **argv) {
+    Inventory *inv = &session->inv;
+    long limit = inv->count;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = strtol(argv[++i], NULL, 10);
+        } else {
+            cli_usage(stderr);
+            return 2;
+        }
+    }
+    if (limit < 0 || limit > inv->count) {
+        limit = inv->count;
+    }
+    
+    int *ids = malloc((size_t)(limit > 0 ? limit : 1) * sizeof(int));
+    int count = ids ? inventory_reorder_list(inv, ids, (int)limit) : -1;
+    if (count == -1) {
+        fprintf(stderr, "stockflow: out of memory\n");
+        free(ids);
+        return 1;
+    }
+    
+    printf("ID,Name,Quantity,Reorder Level,Shortfall\n");
+    for (int i = 0; i < count; i++) {
+        InventoryItem item;
+        inventory_get_item(inv, ids[i], &item);
+        printf("%d,", item.id);
+        cli_print_name(stdout, item.name);
+        printf(",%d,%d,%lld\n", item.quantity, item.reorder_level, (long long)item.reorder_level - item.quantity);
+    }
+    
+    free(ids);
+    return 0;
+}
+
+static int cli_run(CliSession *session, const char *command, int argc, char **argv) {
+    if (strcmp(command, "query") == 0) {
+        return cli_query(session, argc, argv);
+    }
+    if (strcmp(command, "stats") == 0 && argc == 0) {
+        return cli_stats(session);
+    }
+    if (strcmp(command, "reorder") == 0) {
+        return cli_reorder(session, argc, argv);
+    }
+    if (strcmp(command, "export") == 0 && argc == 1) {
+        if (!save_inventory_to_file(&session->inv, argv[0])) {
+            fprintf(stderr, "stockflow: cannot write %s\n", argv[0]);
+            return 1;
+        }
+        return 0;
+    }
+    if (strcmp(command, "import") == 0 && argc == 1) {
+        return cli_import(session, argv[0]);
+    }
+    if (strcmp(command, "apply") == 0 && argc == 1) {
+        return cli_apply(session, argv[0]);
+    }
+    
+    if (strcmp(command, "add") == 0 && argc == 3) {
+        int id;
+        if (!cli_add(&session->inv, argv[0], argv[1], argv[2], &id) || !cli_save(session)) {
+            return 1;
+        }
+        printf("%d\n", id);
+        return 0;
+    }
+    if (strcmp(command, "update") == 0 && argc == 4) {
+        return cli_update(&session->inv, argv[0], argv[1], argv[2], argv[3]) && cli_save(session) ? 0 : 1;
+    }
+    if (strcmp(command, "reorder-level") == 0 && argc == 2) {
+        return cli_set_reorder_level(&session->inv, argv[0], argv[1]) && cli_save(session) ? 0 : 1;
+    }
+    if (strcmp(command, "delete") == 0 && argc >= 1) {
+        for (int i = 0; i < argc; i++) {
+            if (!cli_delete(&session->inv, argv[i])) {
+                return 1;
+            }
+        }
+        return cli_save(session) ? 0 : 1;
+    }
+    
+    cli_usage(stderr);
+    return 2;
+}
+
+int main(int argc, char *argv[]) {
+    const char *filename = CLI_DEFAULT_FILE;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-f") == 0) {
+        filename = argv[2];
+        first = 3;
+    }
+    if (first >= argc || strcmp(argv[first], "--help") == 0 || strcmp(argv[first], "-h") == 0) {
+        cli_usage(first >= argc ? stderr : stdout);
+        return first >= argc ? 2 : 0;
+    }
+    
+    // Query output can run to millions of lines
+    static char output_buffer[1 << 16];
+    setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+    
+    CliSession session;
+    if (!cli_open(&session, filename)) {
+        return 1;
+    }
+    int status = cli_run(&session, argv[first], argc - first - 1, argv + first + 1);
+    cli_close(&session);
+    
+    // Latency of this run's load, save and item operations, for batch jobs
+    const char *metrics_filename = getenv("STOCKFLOW_METRICS_FILE");
+    if (metrics_filename && !metrics_write_file(metrics_filename)) {
+        fprintf(stderr, "stockflow: cannot write metrics to %s\n", metrics_filename);
+    }
+    return status;
+}
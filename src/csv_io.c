@@ -0,0 +1,626 @@
+#define _POSIX_C_SOURCE 200809L  // For sysconf and pthreads
+#include "csv_io.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>     // For signbit and isfinite
+#include <pthread.h>
+#include <unistd.h>
+
+// Files are split into chunks of at least this many bytes, so small files
+// are parsed on the calling thread without spawning any workers
+#define CSV_MIN_CHUNK_SIZE (1 << 20)
+#define CSV_MAX_THREADS 16
+
+// Longest price text handed to strtod when the fast path gives up
+#define CSV_MAX_NUMBER_LENGTH 64
+
+typedef struct {
+    int id;
+    int quantity;
+    float price;
+    int reorder_level;
+    uint32_t name_offset;  // Into the owning chunk's names buffer
+} CsvRow;
+
+// One newline-aligned slice of the file and the rows parsed from it
+typedef struct {
+    const char *begin;
+    const char *end;
+    CsvRow *rows;
+    int count;
+    int capacity;
+    char *names;  // NUL-terminated names, unescaped
+    size_t names_used;
+    size_t names_capacity;
+    bool failed;  // Out of memory; the load is abandoned
+} CsvChunk;
+
+// Output is formatted into this buffer and written in large blocks
+#define CSV_WRITE_BUFFER_SIZE (1 << 20)
+
+// Upper bound on one formatted row: three ints, a fully escaped quoted name
+// and a price printed by the %.2f fallback
+#define CSV_MAX_ROW_LENGTH (3 * 11 + 2 * MAX_NAME_LENGTH + 2 + CSV_MAX_NUMBER_LENGTH + 5)
+
+typedef struct {
+    FILE *file;
+    char *buffer;
+    size_t used;
+    uint64_t written;  // Bytes flushed so far
+    bool failed;       // A write failed; later flushes are skipped
+} CsvWriter;
+
+static void csv_writer_flush(CsvWriter *writer) {
+    if (!writer->failed && writer->used > 0 &&
+        fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        writer->failed = true;
+    }
+    writer->written += writer->used;
+    writer->used = 0;
+}
+
+// Makes room for one row
+static char *csv_writer_reserve(CsvWriter *writer) {
+    if (CSV_WRITE_BUFFER_SIZE - writer->used < CSV_MAX_ROW_LENGTH) {
+        csv_writer_flush(writer);
+    }
+    return writer->buffer + writer->used;
+}
+
+static char *csv_format_int(char *out, int value) {
+    char digits[10];
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    int length = 0;
+    do {
+        digits[length++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    
+    if (value < 0) {
+        *out++ = '-';
+    }
+    while (length > 0) {
+        *out++ = digits[--length];
+    }
+    return out;
+}
+
+// Prints the price with two decimals exactly like "%.2f". A float times 100
+// is exact in a double, so rounding the scaled value half-to-even gives the
+// same digits printf does.
+static char *csv_format_price(char *out, float price) {
+    double scaled = (double)price * 100.0;
+    if (!(scaled > -1e15 && scaled < 1e15)) {
+        // Huge, infinite or NaN; rare enough to leave to snprintf
+        int length = snprintf(out, CSV_MAX_NUMBER_LENGTH, "%.2f", price);
+        return out + (length > 0 && length < CSV_MAX_NUMBER_LENGTH ? length : 0);
+    }
+    
+    // printf keeps the sign of negative values that round to zero
+    bool negative = signbit(scaled);
+    if (negative) {
+        *out++ = '-';
+        scaled = -scaled;
+    }
+    long long cents = (long long)scaled;
+    double remainder = scaled - (double)cents;
+    if (remainder > 0.5 || (remainder == 0.5 && (cents & 1))) {
+        cents++;
+    }
+    
+    char digits[20];
+    long long whole = cents / 100;
+    int length = 0;
+    do {
+        digits[length++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    while (length > 0) {
+        *out++ = digits[--length];
+    }
+    *out++ = '.';
+    *out++ = (char)('0' + cents / 10 % 10);
+    *out++ = (char)('0' + cents % 10);
+    return out;
+}
+
+// Always quotes the name, doubling any quotes inside it
+static char *csv_format_name(char *out, const char *name, size_t length) {
+    *out++ = '"';
+    for (size_t i = 0; i < length; i++) {
+        if (name[i] == '"') {
+            *out++ = '"';
+        }
+        *out++ = name[i];
+    }
+    *out++ = '"';
+    return out;
+}
+
+// Opens the temp file and writes the header
+static bool csv_writer_open(CsvWriter *writer, const char *filename, AtomicFile *output) {
+    *writer = (CsvWriter){NULL, malloc(CSV_WRITE_BUFFER_SIZE), 0, 0, false};
+    if (!writer->buffer || !atomic_file_open(output, filename)) {
+        free(writer->buffer);
+        return false;
+    }
+    writer->file = output->file;
+    setvbuf(writer->file, NULL, _IONBF, 0);  // Writes are already batched
+    
+    static const char header[] = "ID,Name,Quantity,Price,Reorder Level\n";
+    memcpy(writer->buffer, header, sizeof(header) - 1);
+    writer->used = sizeof(header) - 1;
+    return true;
+}
+
+static void csv_write_row(CsvWriter *writer, int id, const char *name, size_t name_length, int quantity,
+                          float price, int reorder_level) {
+    char *out = csv_writer_reserve(writer);
+    char *start = out;
+    out = csv_format_int(out, id);
+    *out++ = ',';
+    out = csv_format_name(out, name, name_length);
+    *out++ = ',';
+    out = csv_format_int(out, quantity);
+    *out++ = ',';
+    out = csv_format_price(out, price);
+    *out++ = ',';
+    out = csv_format_int(out, reorder_level);
+    *out++ = '\n';
+    writer->used += (size_t)(out - start);
+}
+
+// Flushes and syncs the temp file, or drops it if a write failed
+static bool csv_writer_finish(CsvWriter *writer, AtomicFile *output) {
+    csv_writer_flush(writer);
+    free(writer->buffer);
+    
+    if (writer->failed) {
+        atomic_file_abort(output);
+        return false;
+    }
+    return atomic_file_finish(output);
+}
+
+bool save_inventory_to_temp_file(const Inventory *inv, const char *filename, AtomicFile *output) {
+    METRICS_START(start);
+    CsvWriter writer;
+    if (!csv_writer_open(&writer, filename, output)) {
+        return false;
+    }
+    
+    // Write inventory items in display order
+    for (int i = 0; i < inv->order_length && !writer.failed; i++) {
+        if (inv->order[i] < 0) {
+            continue;  // Deleted entry awaiting compaction
+        }
+        int slot = inv->order[i];
+        csv_write_row(&writer, inv->ids[slot], inventory_name_at(inv, slot), inv->name_lengths[slot],
+                      inv->quantities[slot], inv->prices[slot], inv->reorder_levels[slot]);
+    }
+    
+    bool finished = csv_writer_finish(&writer, output);
+    if (!writer.failed) {
+        METRICS_RECORD(METRIC_SAVE, start, writer.written);
+    }
+    return finished;
+}
+
+bool save_inventory_to_file(const Inventory *inv, const char *filename) {
+    AtomicFile output;
+    return save_inventory_to_temp_file(inv, filename, &output) && atomic_file_replace(&output);
+}
+
+bool save_inventory_version_to_temp_file(const InventoryVersion *version, const char *filename, AtomicFile *output) {
+    METRICS_START(start);
+    CsvWriter writer;
+    if (!csv_writer_open(&writer, filename, output)) {
+        return false;
+    }
+    
+    for (int position = 0; position < version->count && !writer.failed; position++) {
+        int slot = inventory_version_slot_at(version, position);
+        const InventoryChunk *chunk = version->chunks[slot / INVENTORY_CHUNK_ROWS];
+        int i = slot % INVENTORY_CHUNK_ROWS;
+        csv_write_row(&writer, chunk->ids[i], chunk->names + chunk->name_offsets[i], chunk->name_lengths[i],
+                      chunk->quantities[i], chunk->prices[i], chunk->reorder_levels[i]);
+    }
+    
+    bool finished = csv_writer_finish(&writer, output);
+    if (!writer.failed) {
+        METRICS_RECORD(METRIC_SAVE, start, writer.written);
+    }
+    return finished;
+}
+
+bool save_inventory_version_to_file(const InventoryVersion *version, const char *filename) {
+    AtomicFile output;
+    return save_inventory_version_to_temp_file(version, filename, &output) && atomic_file_replace(&output);
+}
+
+static int csv_thread_count(size_t size) {
+    long cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (cpus < 1) {
+        cpus = 1;
+    }
+    
+    size_t chunks = size / CSV_MIN_CHUNK_SIZE;
+    if (chunks < 1) {
+        chunks = 1;
+    }
+    if (chunks > (size_t)cpus) {
+        chunks = (size_t)cpus;
+    }
+    if (chunks > CSV_MAX_THREADS) {
+        chunks = CSV_MAX_THREADS;
+    }
+    return (int)chunks;
+}
+
+static const char *csv_skip_spaces(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+// Parses an optionally signed decimal int spanning the whole field
+static bool csv_parse_int(const char *p, const char *end, int *value) {
+    p = csv_skip_spaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    
+    long long result = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + (*p - '0');
+        if (result > (long long)INT_MAX + 1) {
+            return false;
+        }
+        p++;
+    }
+    if (csv_skip_spaces(p, end) != end) {
+        return false;
+    }
+    
+    if (negative) {
+        result = -result;
+    }
+    if (result > INT_MAX || result < INT_MIN) {
+        return false;
+    }
+    *value = (int)result;
+    return true;
+}
+
+// Plain "123.45" prices are converted by hand; anything else (exponents,
+// very long fractions) goes through strtod
+static bool csv_parse_price(const char *p, const char *end, float *value) {
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+    };
+    
+    p = csv_skip_spaces(p, end);
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+    
+    const char *q = p;
+    bool negative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+        negative = *q == '-';
+        q++;
+    }
+    
+    unsigned long long integer = 0;
+    int integer_digits = 0;
+    while (q < end && *q >= '0' && *q <= '9' && integer_digits < 18) {
+        integer = integer * 10 + (unsigned long long)(*q - '0');
+        integer_digits++;
+        q++;
+    }
+    
+    unsigned long long fraction = 0;
+    int fraction_digits = 0;
+    if (q < end && *q == '.') {
+        q++;
+        while (q < end && *q >= '0' && *q <= '9' && fraction_digits < 18) {
+            fraction = fraction * 10 + (unsigned long long)(*q - '0');
+            fraction_digits++;
+            q++;
+        }
+    }
+    
+    if (q == end && integer_digits + fraction_digits > 0) {
+        double result = (double)integer + (double)fraction / powers_of_ten[fraction_digits];
+        *value = (float)(negative ? -result : result);
+        return true;
+    }
+    
+    char text[CSV_MAX_NUMBER_LENGTH];
+    size_t length = (size_t)(end - p);
+    if (length == 0 || length >= sizeof(text)) {
+        return false;
+    }
+    memcpy(text, p, length);
+    text[length] = '\0';
+    
+    char *parsed_end;
+    double result = strtod(text, &parsed_end);
+    if (parsed_end != text + length || !isfinite((float)result)) {
+        return false;  // Not a number, or nan / inf, as validate_price also rejects
+    }
+    *value = (float)result;
+    return true;
+}
+
+static bool csv_chunk_reserve_names(CsvChunk *chunk, size_t min_capacity) {
+    if (min_capacity <= chunk->names_capacity) {
+        return true;
+    }
+    
+    size_t new_capacity = chunk->names_capacity > 0 ? chunk->names_capacity : 4096;
+    while (new_capacity < min_capacity) {
+        new_capacity *= 2;
+    }
+    
+    char *names = realloc(chunk->names, new_capacity);
+    if (!names) {
+        return false;
+    }
+    chunk->names = names;
+    chunk->names_capacity = new_capacity;
+    return true;
+}
+
+static bool csv_chunk_reserve_rows(CsvChunk *chunk) {
+    if (chunk->count < chunk->capacity) {
+        return true;
+    }
+    if (chunk->capacity > INT_MAX / 2) {
+        return false;
+    }
+    
+    int new_capacity = chunk->capacity > 0 ? chunk->capacity * 2 : 1024;
+    CsvRow *rows = realloc(chunk->rows, (size_t)new_capacity * sizeof(CsvRow));
+    if (!rows) {
+        return false;
+    }
+    chunk->rows = rows;
+    chunk->capacity = new_capacity;
+    return true;
+}
+
+// Parses the name field starting at p into the chunk's names buffer. Quoted
+// names may contain commas and "" escapes. Returns the position of the
+// separating comma, or NULL if the field is malformed or memory ran out.
+static const char *csv_parse_name(CsvChunk *chunk, const char *p, const char *end, uint32_t *offset) {
+    // The stored name is never longer than the raw field
+    if (!csv_chunk_reserve_names(chunk, chunk->names_used + (size_t)(end - p) + 1) ||
+        chunk->names_used > UINT32_MAX) {
+        chunk->failed = true;
+        return NULL;
+    }
+    
+    char *out = chunk->names + chunk->names_used;
+    size_t length = 0;
+    
+    const char *quote = csv_skip_spaces(p, end);
+    if (quote < end && *quote == '"') {
+        p = quote + 1;
+        for (;;) {
+            if (p == end) {
+                return NULL;  // Unterminated quote
+            }
+            if (*p == '"') {
+                if (p + 1 < end && p[1] == '"') {
+                    p++;  // Escaped quote; emit one
+                } else {
+                    p++;
+                    break;
+                }
+            }
+            if (length < MAX_NAME_LENGTH - 1) {
+                out[length++] = *p;
+            }
+            p++;
+        }
+        p = csv_skip_spaces(p, end);
+        if (p == end || *p != ',') {
+            return NULL;
+        }
+    } else {
+        const char *comma = memchr(p, ',', (size_t)(end - p));
+        if (!comma) {
+            return NULL;
+        }
+        length = (size_t)(comma - p);
+        if (length > MAX_NAME_LENGTH - 1) {
+            length = MAX_NAME_LENGTH - 1;
+        }
+        memcpy(out, p, length);
+        p = comma;
+    }
+    
+    out[length] = '\0';
+    *offset = (uint32_t)chunk->names_used;
+    chunk->names_used += length + 1;
+    return p;
+}
+
+// Parses one line (without its newline); malformed rows are skipped
+static void csv_parse_line(CsvChunk *chunk, const char *p, const char *end) {
+    if (end > p && end[-1] == '\r') {
+        end--;
+    }
+    if (p == end) {
+        return;
+    }
+    
+    CsvRow row;
+    const char *comma = memchr(p, ',', (size_t)(end - p));
+    if (!comma || !csv_parse_int(p, comma, &row.id)) {
+        return;
+    }
+    
+    size_t names_used = chunk->names_used;
+    p = csv_parse_name(chunk, comma + 1, end, &row.name_offset);
+    if (!p) {
+        return;
+    }
+    
+    p++;
+    comma = memchr(p, ',', (size_t)(end - p));
+    const char *price_end = comma ? memchr(comma + 1, ',', (size_t)(end - comma - 1)) : NULL;
+    if (!comma || !csv_parse_int(p, comma, &row.quantity) ||
+        !csv_parse_price(comma + 1, price_end ? price_end : end, &row.price)) {
+        chunk->names_used = names_used;  // Drop the name stored for this row
+        return;
+    }
+    
+    // The reorder level is optional, as files written before it existed
+    // have none; a missing or unusable one means no level, and anything
+    // after it is ignored
+    row.reorder_level = 0;
+    if (price_end) {
+        const char *level_end = memchr(price_end + 1, ',', (size_t)(end - price_end - 1));
+        if (!csv_parse_int(price_end + 1, level_end ? level_end : end, &row.reorder_level) ||
+            row.reorder_level < 0) {
+            row.reorder_level = 0;
+        }
+    }
+    
+    if (!csv_chunk_reserve_rows(chunk)) {
+        chunk->failed = true;
+        return;
+    }
+    chunk->rows[chunk->count++] = row;
+}
+
+static void *csv_parse_chunk(void *arg) {
+    CsvChunk *chunk = arg;
+    const char *p = chunk->begin;
+    
+    while (p < chunk->end && !chunk->failed) {
+        const char *newline = memchr(p, '\n', (size_t)(chunk->end - p));
+        const char *line_end = newline ? newline : chunk->end;
+        csv_parse_line(chunk, p, line_end);
+        p = line_end + 1;
+    }
+    return NULL;
+}
+
+// Returns the start of the line following position p
+static const char *csv_next_line(const char *p, const char *end) {
+    const char *newline = memchr(p, '\n', (size_t)(end - p));
+    return newline ? newline + 1 : end;
+}
+
+bool load_inventory_from_file(Inventory *inv, const char *filename) {
+    METRICS_START(start);
+    MappedFile file;
+    if (!mapped_file_open(&file, filename)) {
+        return false;
+    }
+    
+    // Skip header line
+    const char *begin = file.data;
+    const char *end = file.data + file.size;
+    if (file.size > 0) {
+        begin = csv_next_line(begin, end);
+    }
+    
+    // Cut the body into newline-aligned chunks of roughly equal size. Names
+    // never contain newlines, so a line is always a whole row.
+    size_t body_size = (size_t)(end - begin);
+    int chunk_count = csv_thread_count(body_size);
+    CsvChunk chunks[CSV_MAX_THREADS];
+    const char *chunk_begin = begin;
+    for (int i = 0; i < chunk_count; i++) {
+        const char *chunk_end = end;
+        if (i < chunk_count - 1) {
+            const char *target = begin + body_size / (size_t)chunk_count * (size_t)(i + 1);
+            chunk_end = target > chunk_begin ? csv_next_line(target - 1, end) : chunk_begin;
+        }
+        
+        chunks[i] = (CsvChunk){0};
+        chunks[i].begin = chunk_begin;
+        chunks[i].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+    
+    // Chunk 0 is parsed here while the workers handle the rest; a worker
+    // that cannot be started has its chunk parsed here as well
+    pthread_t threads[CSV_MAX_THREADS];
+    bool started[CSV_MAX_THREADS] = {false};
+    for (int i = 1; i < chunk_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, csv_parse_chunk, &chunks[i]) == 0;
+    }
+    for (int i = 0; i < chunk_count; i++) {
+        if (!started[i]) {
+            csv_parse_chunk(&chunks[i]);
+        }
+    }
+    
+    bool failed = false;
+    size_t total_rows = 0;
+    size_t total_names = 0;
+    for (int i = 0; i < chunk_count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        failed = failed || chunks[i].failed;
+        total_rows += (size_t)chunks[i].count;
+        total_names += chunks[i].names_used;
+    }
+    mapped_file_close(&file);
+    
+    // Merge in file order so the first of any repeated ids wins. Reserving
+    // up front keeps the per-row inserts from reallocating; if that or an
+    // insert still fails, the inventory is left empty rather than partial,
+    // so it cannot be saved over the file it came from.
+    failed = failed || total_rows > INT_MAX;
+    if (!failed) {
+        inventory_clear(inv);
+        failed = !inventory_reserve(inv, (int)total_rows) ||
+                 !id_index_reserve(&inv->id_index, (int)total_rows) ||
+                 !name_heap_reserve(&inv->name_heap, total_names);
+        
+        for (int i = 0; i < chunk_count && !failed; i++) {
+            for (int j = 0; j < chunks[i].count && !failed; j++) {
+                const CsvRow *row = &chunks[i].rows[j];
+                if (id_index_get(&inv->id_index, row->id) != -1) {
+                    continue;
+                }
+                failed = inventory_insert_item(inv, row->id, chunks[i].names + row->name_offset,
+                                               row->quantity, row->price) == -1 ||
+                         (row->reorder_level > 0 && !inventory_set_reorder_level(inv, row->id, row->reorder_level));
+            }
+        }
+        
+        if (failed) {
+            inventory_clear(inv);
+        }
+        inventory_mark_saved(inv, inv->version);
+    }
+    
+    for (int i = 0; i < chunk_count; i++) {
+        free(chunks[i].rows);
+        free(chunks[i].names);
+    }
+    METRICS_RECORD(METRIC_LOAD, start, file.size);
+    return !failed;
+}
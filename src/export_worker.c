@@ -0,0 +1,43 @@
+#define _POSIX_C_SOURCE 200809L  // For pthreads
+#include "export_worker.h"
+#include "csv_io.h"
+
+static void *export_worker_main(void *arg) {
+    ExportWorker *worker = arg;
+    
+    int reader = inventory_publisher_register(worker->publisher);
+    if (reader >= 0) {
+        const InventoryVersion *version = inventory_publisher_enter(worker->publisher, reader);
+        if (version) {
+            worker->ok = save_inventory_version_to_file(version, worker->filename);
+            worker->version = version->version;
+        }
+        inventory_publisher_exit(worker->publisher, reader);
+        inventory_publisher_unregister(worker->publisher, reader);
+    }
+    
+    if (worker->callback) {
+        worker->callback(worker->ok, worker->version, worker->user_data);
+    }
+    return NULL;
+}
+
+bool export_worker_start(ExportWorker *worker, InventoryPublisher *publisher, const char *filename,
+                         ExportWorkerCallback callback, void *user_data) {
+    worker->publisher = publisher;
+    worker->filename = filename;
+    worker->callback = callback;
+    worker->user_data = user_data;
+    worker->ok = false;
+    worker->version = 0;
+    
+    worker->threaded = pthread_create(&worker->thread, NULL, export_worker_main, worker) == 0;
+    return worker->threaded;
+}
+
+void export_worker_join(ExportWorker *worker) {
+    if (worker->threaded) {
+        pthread_join(worker->thread, NULL);
+        worker->threaded = false;
+    }
+}
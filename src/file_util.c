@@ -0,0 +1,190 @@
+#define _POSIX_C_SOURCE 200809L  // For mmap, fsync and strndup
+#include "file_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <io.h>       // For _commit
+#include <windows.h>  // For MoveFileExA
+#endif
+
+#ifndef _WIN32
+bool mapped_file_open(MappedFile *file, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) == -1 || (uintmax_t)info.st_size > SIZE_MAX) {
+        close(fd);
+        return false;
+    }
+    
+    file->data = NULL;
+    file->size = (size_t)info.st_size;
+    file->mapped = false;
+    if (file->size == 0) {
+        close(fd);
+        return true;  // mmap rejects empty files
+    }
+    
+    void *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping stays valid without the descriptor
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    
+    posix_madvise(data, file->size, POSIX_MADV_SEQUENTIAL);
+    file->data = data;
+    file->mapped = true;
+    return true;
+}
+#else
+// No mmap here; read the whole file into one buffer instead
+bool mapped_file_open(MappedFile *file, const char *filename) {
+    FILE *handle = fopen(filename, "rb");
+    if (!handle) {
+        return false;
+    }
+    
+    long size = -1;
+    if (fseek(handle, 0, SEEK_END) == 0) {
+        size = ftell(handle);
+    }
+    if (size < 0 || fseek(handle, 0, SEEK_SET) != 0) {
+        fclose(handle);
+        return false;
+    }
+    
+    char *data = malloc(size > 0 ? (size_t)size : 1);
+    if (!data || fread(data, 1, (size_t)size, handle) != (size_t)size) {
+        free(data);
+        fclose(handle);
+        return false;
+    }
+    
+    fclose(handle);
+    file->data = data;
+    file->size = (size_t)size;
+    file->mapped = false;
+    return true;
+}
+#endif
+
+void mapped_file_close(MappedFile *file) {
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap((void *)file->data, file->size);
+        file->data = NULL;
+        return;
+    }
+#endif
+    free((void *)file->data);
+    file->data = NULL;
+}
+
+bool file_sync(FILE *file) {
+    if (fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool atomic_file_open(AtomicFile *file, const char *filename) {
+    size_t length = strlen(filename);
+    file->temp_filename = malloc(length + sizeof(".tmp"));
+    if (!file->temp_filename) {
+        return false;
+    }
+    memcpy(file->temp_filename, filename, length);
+    memcpy(file->temp_filename + length, ".tmp", sizeof(".tmp"));
+    
+    file->file = fopen(file->temp_filename, "wb");
+    if (!file->file) {
+        free(file->temp_filename);
+        return false;
+    }
+    file->filename = filename;
+    return true;
+}
+
+static bool atomic_file_rename(const char *temp_filename, const char *filename) {
+#ifdef _WIN32
+    return MoveFileExA(temp_filename, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (rename(temp_filename, filename) != 0) {
+        return false;
+    }
+    
+    // Persist the rename itself; failing here leaves a complete file either way
+    const char *slash = strrchr(filename, '/');
+    char *directory = slash ? strndup(filename, (size_t)(slash - filename) + 1) : NULL;
+    int fd = open(directory ? directory : ".", O_RDONLY);
+    if (fd != -1) {
+        fsync(fd);
+        close(fd);
+    }
+    free(directory);
+    return true;
+#endif
+}
+
+bool atomic_file_finish(AtomicFile *file) {
+    bool ok = file_sync(file->file);
+    ok = fclose(file->file) == 0 && ok;
+    file->file = NULL;
+    if (!ok) {
+        atomic_file_abort(file);
+    }
+    return ok;
+}
+
+bool atomic_file_replace(AtomicFile *file) {
+    bool ok = atomic_file_rename(file->temp_filename, file->filename);
+    if (!ok) {
+        remove(file->temp_filename);
+    }
+    free(file->temp_filename);
+    return ok;
+}
+
+bool atomic_file_commit(AtomicFile *file) {
+    return atomic_file_finish(file) && atomic_file_replace(file);
+}
+
+void atomic_file_abort(AtomicFile *file) {
+    if (file->file) {
+        fclose(file->file);
+    }
+    remove(file->temp_filename);
+    free(file->temp_filename);
+}
+
+bool file_stamp_get(const char *filename, FileStamp *stamp) {
+    struct stat info;
+    if (stat(filename, &info) != 0) {
+        return false;
+    }
+    stamp->size = (uint64_t)info.st_size;
+#ifndef _WIN32
+    stamp->mtime_ns = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#else
+    stamp->mtime_ns = (int64_t)info.st_mtime * 1000000000;
+#endif
+    stamp->inode = (uint64_t)info.st_ino;
+    return true;
+}
+
+bool file_stamp_equal(const FileStamp *a, const FileStamp *b) {
+    return a->size == b->size && a->mtime_ns == b->mtime_ns && a->inode == b->inode;
+}
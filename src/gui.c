@@ -1,5 +1,8 @@
 #include "gui.h"
 #include "utils.h"
+#include "snapshot.h"
+#include "save_worker.h"
+#include "inventory_model.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +15,20 @@ static void add_css_class(GtkWidget *widget, const char *class_name) {
     }
 }
 
+void show_error_dialog(GtkWidget *parent, const char *message) {
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
+        GTK_DIALOG_MODAL, GTK_MESSAGE_ERROR, GTK_BUTTONS_OK, "%s", message);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
+void show_info_dialog(GtkWidget *parent, const char *message) {
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
+        GTK_DIALOG_MODAL, GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", message);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
 GtkWidget* create_main_window(AppData *app_data) {
     // Create main window
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -68,7 +85,7 @@ GtkWidget* create_main_window(AppData *app_data) {
     gtk_entry_set_placeholder_text(GTK_ENTRY(app_data->search_entry), "Search by product name...");
     add_css_class(app_data->search_entry, "search-entry");
     gtk_widget_set_size_request(app_data->search_entry, -1, 40);
-    g_signal_connect(app_data->search_entry, "search-changed", G_CALLBACK(on_search_entry_changed), app_data);
+    g_signal_connect(app_data->search_entry, "changed", G_CALLBACK(on_search_entry_changed), app_data);
     gtk_box_pack_start(GTK_BOX(left_vbox), app_data->search_entry, FALSE, FALSE, 0);
     
     // Inventory table title
@@ -92,26 +109,32 @@ GtkWidget* create_main_window(AppData *app_data) {
     gtk_paned_pack2(GTK_PANED(paned), right_vbox, FALSE, TRUE);
     setup_input_form(app_data, right_vbox);
     
-    // Enhanced status bar
+    // Enhanced status bar: messages on the left, live totals on the right
+    GtkWidget *status_bar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 16);
+    add_css_class(status_bar, "status-bar");
+    gtk_box_pack_end(GTK_BOX(content_container), status_bar, FALSE, FALSE, 0);
     app_data->status_label = gtk_label_new("🚀 StockFlow Ready - Professional Inventory Management");
     gtk_widget_set_halign(app_data->status_label, GTK_ALIGN_START);
-    add_css_class(app_data->status_label, "status-bar");
-    gtk_box_pack_end(GTK_BOX(content_container), app_data->status_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(status_bar), app_data->status_label, TRUE, TRUE, 0);
+    app_data->totals_label = gtk_label_new("");
+    gtk_widget_set_halign(app_data->totals_label, GTK_ALIGN_END);
+    gtk_box_pack_end(GTK_BOX(status_bar), app_data->totals_label, FALSE, FALSE, 0);
     
     app_data->window = window;
     return window;
 }
 
 void setup_tree_view(AppData *app_data) {
-    // Create list store
-    app_data->list_store = gtk_list_store_new(NUM_COLS, G_TYPE_INT, G_TYPE_STRING, G_TYPE_INT, G_TYPE_FLOAT);
+    // Rows are read from the inventory on demand rather than copied into a list store
+    app_data->model = inventory_model_new(app_data->inventory);
     
     // Create tree view with enhanced styling
-    app_data->tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(app_data->list_store));
+    app_data->tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(app_data->model));
     add_css_class(app_data->tree_view, "data-table");
     
     // Create columns with enhanced styling
     const char *column_titles[] = {"ID", "Product Name", "Quantity", "Price ($)"};
+    const int column_widths[] = {80, 320, 120, 120};
     
     for (int i = 0; i < NUM_COLS; i++) {
         GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
@@ -125,6 +148,9 @@ void setup_tree_view(AppData *app_data) {
         GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(
             column_titles[i], renderer, "text", i, NULL);
         
+        // Fixed sizing lets the view skip measuring every row
+        gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+        gtk_tree_view_column_set_fixed_width(column, column_widths[i]);
         gtk_tree_view_column_set_resizable(column, TRUE);
         gtk_tree_view_column_set_sort_column_id(column, i);
         gtk_tree_view_column_set_clickable(column, TRUE);
@@ -139,6 +165,9 @@ void setup_tree_view(AppData *app_data) {
         g_signal_connect(column, "clicked", G_CALLBACK(on_column_header_clicked), app_data);
     }
     
+    // All rows share one height, so scrolling cost does not grow with the row count
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(app_data->tree_view), TRUE);
+    
     // Setup selection
     GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(app_data->tree_view));
     gtk_tree_selection_set_mode(selection, GTK_SELECTION_SINGLE);
@@ -148,6 +177,7 @@ void setup_tree_view(AppData *app_data) {
 void setup_input_form(AppData *app_data, GtkWidget *container) {
     // Create frame with enhanced title
     GtkWidget *frame = gtk_frame_new("📝 Item Management");
+    app_data->input_frame = frame;
     add_css_class(frame, "input-frame");
     gtk_box_pack_start(GTK_BOX(container), frame, FALSE, TRUE, 0);
     
@@ -195,6 +225,17 @@ void setup_input_form(AppData *app_data, GtkWidget *container) {
     gtk_grid_attach(GTK_GRID(grid), price_label, 0, 2, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), app_data->price_entry, 1, 2, 1, 1);
     
+    // Reorder level; items with fewer units than this show in the Reorder view
+    GtkWidget *reorder_label = gtk_label_new("🔔 Reorder Level:");
+    add_css_class(reorder_label, "form-label");
+    gtk_widget_set_halign(reorder_label, GTK_ALIGN_END);
+    app_data->reorder_entry = gtk_entry_new();
+    add_css_class(app_data->reorder_entry, "form-input");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(app_data->reorder_entry), "0 (no reminder)");
+    gtk_widget_set_size_request(app_data->reorder_entry, 250, 42);
+    gtk_grid_attach(GTK_GRID(grid), reorder_label, 0, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), app_data->reorder_entry, 1, 3, 1, 1);
+    
     // Action buttons with enhanced styling
     GtkWidget *button_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 12);
     gtk_widget_set_halign(button_box, GTK_ALIGN_CENTER);
@@ -228,6 +269,7 @@ void setup_input_form(AppData *app_data, GtkWidget *container) {
 
 void setup_toolbar(AppData *app_data, GtkWidget *container) {
     GtkWidget *toolbar = gtk_toolbar_new();
+    app_data->toolbar = toolbar;
     add_css_class(toolbar, "main-toolbar");
     gtk_box_pack_start(GTK_BOX(container), toolbar, FALSE, FALSE, 0);
     
@@ -247,6 +289,30 @@ void setup_toolbar(AppData *app_data, GtkWidget *container) {
     g_signal_connect(load_item, "clicked", G_CALLBACK(on_load_clicked), app_data);
     gtk_toolbar_insert(GTK_TOOLBAR(toolbar), load_item, -1);
     
+    // Performance view
+    GtkToolItem *performance_item = gtk_tool_button_new(NULL, "📈 Performance");
+    gtk_tool_button_set_icon_name(GTK_TOOL_BUTTON(performance_item), "utilities-system-monitor");
+    gtk_widget_set_tooltip_text(GTK_WIDGET(performance_item), "Show operation latency statistics");
+    add_css_class(GTK_WIDGET(performance_item), "toolbar-button");
+    g_signal_connect(performance_item, "clicked", G_CALLBACK(on_performance_clicked), app_data);
+    gtk_toolbar_insert(GTK_TOOLBAR(toolbar), performance_item, -1);
+    
+    // Reorder view
+    GtkToolItem *reorder_item = gtk_tool_button_new(NULL, "🔔 Reorder");
+    gtk_tool_button_set_icon_name(GTK_TOOL_BUTTON(reorder_item), "dialog-warning");
+    gtk_widget_set_tooltip_text(GTK_WIDGET(reorder_item), "Show items below their reorder level");
+    add_css_class(GTK_WIDGET(reorder_item), "toolbar-button");
+    g_signal_connect(reorder_item, "clicked", G_CALLBACK(on_reorder_clicked), app_data);
+    gtk_toolbar_insert(GTK_TOOLBAR(toolbar), reorder_item, -1);
+    
+    // Export button
+    GtkToolItem *export_item = gtk_tool_button_new(NULL, "📤 Export");
+    gtk_tool_button_set_icon_name(GTK_TOOL_BUTTON(export_item), "document-send");
+    gtk_widget_set_tooltip_text(GTK_WIDGET(export_item), "Export the table as shown to inventory_export.csv");
+    add_css_class(GTK_WIDGET(export_item), "toolbar-button");
+    g_signal_connect(export_item, "clicked", G_CALLBACK(on_export_clicked), app_data);
+    gtk_toolbar_insert(GTK_TOOLBAR(toolbar), export_item, -1);
+    
     // Separator
     GtkToolItem *sep = gtk_separator_tool_item_new();
     gtk_toolbar_insert(GTK_TOOLBAR(toolbar), sep, -1);
@@ -261,39 +327,55 @@ void setup_toolbar(AppData *app_data, GtkWidget *container) {
     gtk_toolbar_insert(GTK_TOOLBAR(toolbar), brand_item, -1);
 }
 
-void refresh_tree_view(AppData *app_data) {
-    gtk_list_store_clear(app_data->list_store);
+// Swaps in a new filter (NULL for every item) in one step: detaching the
+// model while it changes lets the view reset instead of processing a signal
+// per row
+static void set_tree_view_filter(AppData *app_data, int *ids, int count) {
+    GtkTreeView *tree_view = GTK_TREE_VIEW(app_data->tree_view);
+    gtk_tree_view_set_model(tree_view, NULL);
+    if (ids) {
+        inventory_model_set_filter(app_data->model, ids, count);
+    } else {
+        inventory_model_clear_filter(app_data->model);
+    }
+    gtk_tree_view_set_model(tree_view, GTK_TREE_MODEL(app_data->model));
+}
+
+static void show_search_results(AppData *app_data, int *ids, int count) {
+    set_tree_view_filter(app_data, ids, count);
+    
+    char status[256];
+    snprintf(status, sizeof(status), "🔍 StockFlow Search: Found %d results for '%s'", count,
+             gtk_entry_get_text(GTK_ENTRY(app_data->search_entry)));
+    update_status(app_data, status);
+}
+
+// Runs the current query on the search worker; the results replace the
+// filter when they arrive. Without a worker the search runs here.
+static void start_search(AppData *app_data) {
+    const char *search_text = gtk_entry_get_text(GTK_ENTRY(app_data->search_entry));
+    if (app_data->search_worker) {
+        app_data->search_generation = search_worker_request(app_data->search_worker, search_text);
+        if (app_data->search_generation != 0) {
+            return;
+        }
+    }
     
+    int max_results = app_data->inventory->count;
+    int *ids = g_new(int, max_results > 0 ? max_results : 1);
+    int count = inventory_search(app_data->inventory, search_text, ids, max_results, NULL, NULL);
+    show_search_results(app_data, ids, count);
+}
+
+void refresh_tree_view(AppData *app_data) {
     const char *search_text = gtk_entry_get_text(GTK_ENTRY(app_data->search_entry));
     
     if (strlen(search_text) == 0) {
         // Show all items
-        for (int i = 0; i < app_data->inventory->count; i++) {
-            GtkTreeIter iter;
-            InventoryItem *item = &app_data->inventory->items[i];
-            gtk_list_store_append(app_data->list_store, &iter);
-            gtk_list_store_set(app_data->list_store, &iter,
-                COL_ID, item->id,
-                COL_NAME, item->name,
-                COL_QUANTITY, item->quantity,
-                COL_PRICE, item->price,
-                -1);
-        }
+        set_tree_view_filter(app_data, NULL, 0);
     } else {
-        // Show filtered items
-        InventoryItem results[MAX_ITEMS];
-        int count = inventory_search(app_data->inventory, search_text, results, MAX_ITEMS);
-        
-        for (int i = 0; i < count; i++) {
-            GtkTreeIter iter;
-            gtk_list_store_append(app_data->list_store, &iter);
-            gtk_list_store_set(app_data->list_store, &iter,
-                COL_ID, results[i].id,
-                COL_NAME, results[i].name,
-                COL_QUANTITY, results[i].quantity,
-                COL_PRICE, results[i].price,
-                -1);
-        }
+        // Results follow display order, so a new order or contents means a new search
+        start_search(app_data);
     }
 }
 
@@ -301,10 +383,32 @@ void update_status(AppData *app_data, const char *message) {
     gtk_label_set_text(GTK_LABEL(app_data->status_label), message);
 }
 
+// Reads the inventory's running totals, so it is cheap after every edit
+void update_totals(AppData *app_data) {
+    Inventory *inv = app_data->inventory;
+    char value[32];
+    format_cents(value, sizeof(value), inventory_stock_value_cents(inv));
+    
+    char totals[160];
+    snprintf(totals, sizeof(totals), "📦 %d items · %lld units · 💰 $%s · ⚠️ %d low", inv->count,
+             (long long)inventory_total_units(inv), value, inventory_count_low_stock(inv, LOW_STOCK_THRESHOLD));
+    gtk_label_set_text(GTK_LABEL(app_data->totals_label), totals);
+}
+
+// Controls that read or change the inventory are disabled while it loads
+void set_loading(AppData *app_data, bool loading) {
+    app_data->loading = loading;
+    gtk_widget_set_sensitive(app_data->toolbar, !loading);
+    gtk_widget_set_sensitive(app_data->input_frame, !loading);
+    gtk_widget_set_sensitive(app_data->search_entry, !loading);
+    gtk_tree_view_set_headers_clickable(GTK_TREE_VIEW(app_data->tree_view), !loading);
+}
+
 void clear_input_fields(AppData *app_data) {
     gtk_entry_set_text(GTK_ENTRY(app_data->name_entry), "");
     gtk_entry_set_text(GTK_ENTRY(app_data->quantity_entry), "");
     gtk_entry_set_text(GTK_ENTRY(app_data->price_entry), "");
+    gtk_entry_set_text(GTK_ENTRY(app_data->reorder_entry), "");
     app_data->selected_id = -1;
     gtk_widget_set_sensitive(app_data->update_button, FALSE);
     gtk_widget_set_sensitive(app_data->delete_button, FALSE);
@@ -321,11 +425,251 @@ void populate_input_fields(AppData *app_data, const InventoryItem *item) {
     snprintf(buffer, sizeof(buffer), "%.2f", item->price);
     gtk_entry_set_text(GTK_ENTRY(app_data->price_entry), buffer);
     
+    snprintf(buffer, sizeof(buffer), "%d", item->reorder_level);
+    gtk_entry_set_text(GTK_ENTRY(app_data->reorder_entry), buffer);
+    
     app_data->selected_id = item->id;
     gtk_widget_set_sensitive(app_data->update_button, TRUE);
     gtk_widget_set_sensitive(app_data->delete_button, TRUE);
 }
 
+// Every change to the inventory is bracketed by these, so the search worker
+// never reads it mid-change
+static void begin_inventory_change(AppData *app_data) {
+    if (app_data->search_worker) {
+        search_worker_lock_inventory(app_data->search_worker);
+    }
+}
+
+static void end_inventory_change(AppData *app_data) {
+    if (app_data->search_worker) {
+        search_worker_unlock_inventory(app_data->search_worker);
+    }
+}
+
+// An empty field means no reorder level
+static bool read_reorder_level(AppData *app_data, int *level) {
+    const char *level_str = gtk_entry_get_text(GTK_ENTRY(app_data->reorder_entry));
+    if (level_str[0] == '\0') {
+        *level = 0;
+        return true;
+    }
+    return validate_quantity(level_str, level);
+}
+
+// Persists a mutation through the journal and checkpoints in the background
+// once enough records have piled up
+static void record_mutation(AppData *app_data, JournalRecordType type, int id) {
+    if (!app_data->journal) {
+        return;
+    }
+    
+    journal_record(app_data->journal, type, app_data->inventory, id);
+    if (app_data->save_worker && journal_needs_checkpoint(app_data->journal)) {
+        save_worker_request(app_data->save_worker, app_data->inventory);
+    }
+}
+
+// Result of a background save, carried from the worker to the main loop
+typedef struct {
+    AppData *app_data;
+    bool ok;
+    uint64_t version;
+} SaveResult;
+
+static gboolean on_save_finished_idle(gpointer data) {
+    SaveResult *result = data;
+    AppData *app_data = result->app_data;
+    bool manual = app_data->manual_save_pending;
+    app_data->manual_save_pending = false;
+    
+    if (result->ok) {
+        inventory_mark_saved(app_data->inventory, result->version);
+        update_status(app_data, manual ? "💾 StockFlow: Inventory saved successfully!"
+                                       : "💾 StockFlow: Changes saved automatically");
+    } else if (manual) {
+        show_error_dialog(app_data->window, "❌ Save Failed\n\nUnable to save inventory. Please check file permissions.");
+    } else {
+        update_status(app_data, "⚠️ StockFlow: Automatic save failed - use Save to retry");
+    }
+    
+    g_free(result);
+    return G_SOURCE_REMOVE;
+}
+
+// Runs on the save worker's thread, so it only hands the result to the main loop
+void on_save_finished(bool ok, uint64_t version, void *user_data) {
+    SaveResult *result = g_new(SaveResult, 1);
+    result->app_data = (AppData *)user_data;
+    result->ok = ok;
+    result->version = version;
+    g_idle_add(on_save_finished_idle, result);
+}
+
+gboolean on_autosave_timeout(gpointer data) {
+    AppData *app_data = (AppData *)data;
+    if (!app_data->loading && inventory_is_dirty(app_data->inventory)) {
+        save_worker_request(app_data->save_worker, app_data->inventory);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Result of a background export, carried from the worker to the main loop
+typedef struct {
+    AppData *app_data;
+    bool ok;
+    uint64_t version;
+} ExportResult;
+
+static gboolean on_export_finished_idle(gpointer data) {
+    ExportResult *result = data;
+    AppData *app_data = result->app_data;
+    export_worker_join(&app_data->export_worker);
+    app_data->exporting = false;
+    
+    if (result->ok) {
+        update_status(app_data, result->version == app_data->inventory->version
+                                    ? "📤 StockFlow: Inventory exported to 'inventory_export.csv'"
+                                    : "📤 StockFlow: Exported to 'inventory_export.csv' (as of when it started)");
+    } else {
+        show_error_dialog(app_data->window, "❌ Export Failed\n\nUnable to write 'inventory_export.csv'. Please check file permissions.");
+    }
+    
+    g_free(result);
+    return G_SOURCE_REMOVE;
+}
+
+// Runs on the export worker's thread, so it only hands the result to the main loop
+void on_export_finished(bool ok, uint64_t version, void *user_data) {
+    ExportResult *result = g_new(ExportResult, 1);
+    result->app_data = (AppData *)user_data;
+    result->ok = ok;
+    result->version = version;
+    g_idle_add(on_export_finished_idle, result);
+}
+
+// Result of a background search, carried from the worker to the main loop
+typedef struct {
+    AppData *app_data;
+    int *ids;
+    int count;
+    uint64_t generation;
+    uint64_t version;
+} SearchResult;
+
+static gboolean on_search_finished_idle(gpointer data) {
+    SearchResult *result = data;
+    AppData *app_data = result->app_data;
+    
+    if (result->generation != app_data->search_generation) {
+        // Superseded by a newer query (or by clearing the search)
+        free(result->ids);
+    } else if (result->version != app_data->inventory->version) {
+        // Edits made since the search ran went to the old filter; search again
+        free(result->ids);
+        start_search(app_data);
+    } else {
+        show_search_results(app_data, result->ids, result->count);
+    }
+    
+    g_free(result);
+    return G_SOURCE_REMOVE;
+}
+
+// Runs on the search worker's thread, so it only hands the result to the main loop
+void on_search_finished(int *ids, int count, uint64_t generation, uint64_t version, void *user_data) {
+    SearchResult *result = g_new(SearchResult, 1);
+    result->app_data = (AppData *)user_data;
+    result->ids = ids;
+    result->count = count;
+    result->generation = generation;
+    result->version = version;
+    g_idle_add(on_search_finished_idle, result);
+}
+
+static gboolean on_search_timeout(gpointer data) {
+    AppData *app_data = (AppData *)data;
+    app_data->search_timeout = 0;
+    start_search(app_data);
+    return G_SOURCE_REMOVE;
+}
+
+// Applies a single-item change to the table. Rows are signalled one at a
+// time, so the view keeps its scroll position and selection; an updated row
+// that moves under the current sort order is selected again at its new place.
+void on_inventory_changed(const InventoryChange *change, void *user_data) {
+    AppData *app_data = (AppData *)user_data;
+    update_totals(app_data);
+    update_reorder_view(app_data);
+    if (change->type == INVENTORY_ITEMS_RESET) {
+        refresh_tree_view(app_data);  // A batch: reset the view once
+        return;
+    }
+    
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(app_data->tree_view));
+    bool reselect = change->type == INVENTORY_ITEM_UPDATED && change->id == app_data->selected_id;
+    
+    inventory_model_apply_change(app_data->model, change);
+    
+    // While searching, a new item is listed only if it matches
+    if (change->type == INVENTORY_ITEM_ADDED && inventory_model_is_filtered(app_data->model)) {
+        const char *search_text = gtk_entry_get_text(GTK_ENTRY(app_data->search_entry));
+        StringMatcher matcher;
+        string_matcher_init(&matcher, search_text);
+        int slot = inventory_get_index_by_id(app_data->inventory, change->id);
+        if (string_matcher_find(&matcher, inventory_name_at(app_data->inventory, slot),
+                                app_data->inventory->name_lengths[slot])) {
+            inventory_model_filter_append(app_data->model, change->id);
+        }
+    }
+    
+    if (reselect && change->old_position != change->new_position && !inventory_model_is_filtered(app_data->model)) {
+        GtkTreePath *path = gtk_tree_path_new_from_indices(change->new_position, -1);
+        gtk_tree_selection_select_path(selection, path);
+        gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(app_data->tree_view), path, NULL, FALSE, 0, 0);
+        gtk_tree_path_free(path);
+    }
+}
+
+static gboolean on_load_finished_idle(gpointer data) {
+    AppData *app_data = (AppData *)data;
+    LoadWorker *worker = app_data->load_worker;
+    load_worker_join(worker);
+    app_data->load_worker = NULL;
+    
+    if (worker->journal_opened) {
+        app_data->journal = worker->journal;
+    }
+    if (app_data->save_worker) {
+        app_data->save_worker->journal = app_data->journal;  // Safe while the worker is idle
+    }
+    
+    // The model reads rows on demand, so showing them all is a single reset;
+    // from here on edits reach the table row by row
+    refresh_tree_view(app_data);
+    update_totals(app_data);
+    update_reorder_view(app_data);
+    inventory_set_listener(app_data->inventory, on_inventory_changed, app_data);
+    set_loading(app_data, false);
+    FileStamp csv_stamp;
+    if (!worker->loaded && file_stamp_get("inventory.csv", &csv_stamp)) {
+        update_status(app_data, "❌ Could not load inventory.csv");
+        show_error_dialog(app_data->window, "❌ Load Failed\n\nUnable to load 'inventory.csv'. Saving now would replace it with what is shown.");
+    } else if (app_data->inventory->count > 0) {
+        update_status(app_data, "📂 Inventory loaded successfully! Ready to manage your stock.");
+    } else {
+        update_status(app_data, "🚀 StockFlow Ready - Welcome to your professional inventory system!");
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// Runs on the load worker's thread; the inventory is only touched from the
+// main loop once on_load_finished_idle has joined it
+void on_load_finished(bool loaded, void *user_data) {
+    (void)loaded;
+    g_idle_add(on_load_finished_idle, user_data);
+}
+
 // Signal handlers (unchanged)
 void on_add_button_clicked(GtkWidget *widget, gpointer data) {
     (void)widget;
@@ -337,6 +681,7 @@ void on_add_button_clicked(GtkWidget *widget, gpointer data) {
     
     int quantity;
     float price;
+    int reorder_level;
     
     if (!validate_name(name)) {
         show_error_dialog(app_data->window, "Please enter a valid item name.");
@@ -353,13 +698,28 @@ void on_add_button_clicked(GtkWidget *widget, gpointer data) {
         return;
     }
     
+    if (!read_reorder_level(app_data, &reorder_level)) {
+        show_error_dialog(app_data->window, "Please enter a valid reorder level (non-negative integer).");
+        return;
+    }
+    
+    begin_inventory_change(app_data);
     int id = inventory_add_item(app_data->inventory, name, quantity, price);
+    if (id != -1 && reorder_level > 0) {
+        inventory_set_reorder_level(app_data->inventory, id, reorder_level);
+    }
+    end_inventory_change(app_data);
     if (id == -1) {
-        show_error_dialog(app_data->window, "Failed to add item. Inventory might be full.");
+        show_error_dialog(app_data->window, "Failed to add item. Not enough memory to grow the inventory.");
         return;
     }
     
-    refresh_tree_view(app_data);
+    // The new row reaches the table through on_inventory_changed
+    record_mutation(app_data, JOURNAL_ADD, id);
+    if (reorder_level > 0) {
+        record_mutation(app_data, JOURNAL_REORDER_LEVEL, id);
+    }
+    gtk_tree_selection_unselect_all(gtk_tree_view_get_selection(GTK_TREE_VIEW(app_data->tree_view)));
     clear_input_fields(app_data);
     update_status(app_data, "✅ Item added successfully - StockFlow updated!");
 }
@@ -379,15 +739,22 @@ void on_update_button_clicked(GtkWidget *widget, gpointer data) {
     
     int quantity;
     float price;
+    int reorder_level;
     
-    if (!validate_name(name) || !validate_quantity(quantity_str, &quantity) || !validate_price(price_str, &price)) {
+    if (!validate_name(name) || !validate_quantity(quantity_str, &quantity) || !validate_price(price_str, &price) ||
+        !read_reorder_level(app_data, &reorder_level)) {
         show_error_dialog(app_data->window, "Please enter valid values for all fields.");
         return;
     }
     
-    if (inventory_update_item(app_data->inventory, app_data->selected_id, name, quantity, price)) {
-        refresh_tree_view(app_data);
-        clear_input_fields(app_data);
+    begin_inventory_change(app_data);
+    bool updated = inventory_update_item(app_data->inventory, app_data->selected_id, name, quantity, price) &&
+                   inventory_set_reorder_level(app_data->inventory, app_data->selected_id, reorder_level);
+    end_inventory_change(app_data);
+    
+    if (updated) {
+        record_mutation(app_data, JOURNAL_UPDATE, app_data->selected_id);
+        record_mutation(app_data, JOURNAL_REORDER_LEVEL, app_data->selected_id);
         update_status(app_data, "✏️ Item updated successfully - StockFlow synchronized!");
     } else {
         show_error_dialog(app_data->window, "Failed to update item.");
@@ -411,8 +778,13 @@ void on_delete_button_clicked(GtkWidget *widget, gpointer data) {
     gtk_widget_destroy(dialog);
     
     if (response == GTK_RESPONSE_YES) {
-        if (inventory_delete_item(app_data->inventory, app_data->selected_id)) {
-            refresh_tree_view(app_data);
+        begin_inventory_change(app_data);
+        bool deleted = inventory_delete_item(app_data->inventory, app_data->selected_id);
+        end_inventory_change(app_data);
+        
+        if (deleted) {
+            // Removing the selected row clears the selection and the form
+            record_mutation(app_data, JOURNAL_DELETE, app_data->selected_id);
             clear_input_fields(app_data);
             update_status(app_data, "🗑️ Item deleted successfully - StockFlow updated!");
         } else {
@@ -430,7 +802,7 @@ void on_tree_selection_changed(GtkTreeSelection *selection, gpointer data) {
         int id;
         gtk_tree_model_get(model, &iter, COL_ID, &id, -1);
         
-        InventoryItem *item = inventory_find_by_id(app_data->inventory, id);
+        const InventoryItem *item = inventory_find_by_id(app_data->inventory, id);
         if (item) {
             populate_input_fields(app_data, item);
         }
@@ -439,17 +811,27 @@ void on_tree_selection_changed(GtkTreeSelection *selection, gpointer data) {
     }
 }
 
+// Keystrokes only restart the debounce timer; the search itself runs on the
+// worker once typing pauses, and each keystroke abandons the one in flight
 void on_search_entry_changed(GtkWidget *widget, gpointer data) {
     (void)widget;
     AppData *app_data = (AppData *)data;
-    refresh_tree_view(app_data);
+    
+    if (app_data->search_timeout) {
+        g_source_remove(app_data->search_timeout);
+        app_data->search_timeout = 0;
+    }
+    if (app_data->search_worker) {
+        search_worker_cancel(app_data->search_worker);
+    }
+    app_data->search_generation = 0;
     
     const char *search_text = gtk_entry_get_text(GTK_ENTRY(app_data->search_entry));
     if (strlen(search_text) > 0) {
-        char status[256];
-        snprintf(status, sizeof(status), "🔍 StockFlow Search: Found results for '%s'", search_text);
-        update_status(app_data, status);
+        app_data->search_timeout = g_timeout_add(SEARCH_DEBOUNCE_MS, on_search_timeout, app_data);
+        update_status(app_data, "🔍 StockFlow Search: Searching...");
     } else {
+        set_tree_view_filter(app_data, NULL, 0);
         update_status(app_data, "📊 StockFlow: Displaying all inventory items");
     }
 }
@@ -467,8 +849,22 @@ void on_column_header_clicked(GtkTreeViewColumn *column, gpointer data) {
         default: return;
     }
     
-    inventory_sort(app_data->inventory, criteria, true);
+    // Clicking the active column again flips the direction
+    Inventory *inv = app_data->inventory;
+    bool ascending = !(inv->sorted && inv->sort_criteria == criteria && inv->sort_ascending);
+    
+    begin_inventory_change(app_data);
+    inventory_sort(inv, criteria, ascending);
+    end_inventory_change(app_data);
     refresh_tree_view(app_data);
+    
+    // The model is not a GtkTreeSortable, so the arrow is set by hand
+    GList *columns = gtk_tree_view_get_columns(GTK_TREE_VIEW(app_data->tree_view));
+    for (GList *l = columns; l; l = l->next) {
+        gtk_tree_view_column_set_sort_indicator(l->data, l->data == column);
+    }
+    g_list_free(columns);
+    gtk_tree_view_column_set_sort_order(column, ascending ? GTK_SORT_ASCENDING : GTK_SORT_DESCENDING);
     update_status(app_data, "📊 StockFlow: Inventory sorted and organized!");
 }
 
@@ -476,7 +872,34 @@ void on_save_clicked(GtkWidget *widget, gpointer data) {
     (void)widget;
     AppData *app_data = (AppData *)data;
     
-    if (save_inventory_to_file(app_data->inventory, "inventory.csv")) {
+    // Saving happens on the worker; on_save_finished reports back
+    if (app_data->save_worker) {
+        if (save_worker_request(app_data->save_worker, app_data->inventory)) {
+            app_data->manual_save_pending = true;
+            update_status(app_data, "💾 StockFlow: Saving inventory...");
+        } else if (save_worker_busy(app_data->save_worker)) {
+            app_data->manual_save_pending = true;
+            update_status(app_data, "💾 StockFlow: A save is already in progress...");
+        } else {
+            show_error_dialog(app_data->window, "❌ Save Failed\n\nNot enough memory to prepare the save.");
+        }
+        return;
+    }
+    
+    // Without a worker, save in place; a checkpoint writes the CSV and
+    // snapshot and trims the journal
+    bool saved;
+    if (app_data->journal) {
+        saved = journal_checkpoint(app_data->journal, app_data->inventory, journal_position(app_data->journal));
+    } else {
+        saved = save_inventory_to_file(app_data->inventory, "inventory.csv");
+        if (saved) {
+            snapshot_save(app_data->inventory, "inventory.snapshot", "inventory.csv");
+        }
+    }
+    
+    if (saved) {
+        inventory_mark_saved(app_data->inventory, app_data->inventory->version);
         update_status(app_data, "💾 StockFlow: Inventory saved successfully!");
         show_info_dialog(app_data->window, "✅ Success!\n\nYour inventory has been saved to 'inventory.csv'.\nStockFlow keeps your data safe!");
     } else {
@@ -488,12 +911,273 @@ void on_load_clicked(GtkWidget *widget, gpointer data) {
     (void)widget;
     AppData *app_data = (AppData *)data;
     
-    if (load_inventory_from_file(app_data->inventory, "inventory.csv")) {
-        refresh_tree_view(app_data);
+    // The journal is reopened against whatever CSV is now on disk, replaying
+    // the edits made since the last save if it is still the same file. A
+    // save in progress uses the journal, so it has to finish first.
+    if (app_data->save_worker) {
+        save_worker_wait(app_data->save_worker);
+    }
+    if (app_data->journal) {
+        journal_close(app_data->journal);
+    }
+    
+    // A reload replaces everything, so the view is reset once afterwards
+    // rather than told about every row
+    begin_inventory_change(app_data);
+    inventory_set_listener(app_data->inventory, NULL, NULL);
+    bool loaded = load_inventory_with_snapshot(app_data->inventory, "inventory.csv", "inventory.snapshot");
+    if (app_data->journal && !journal_open(app_data->journal, "inventory.journal", "inventory.csv",
+                                           "inventory.snapshot", app_data->inventory)) {
+        app_data->journal = NULL;
+    }
+    if (app_data->save_worker) {
+        app_data->save_worker->journal = app_data->journal;  // Safe while the worker is idle
+    }
+    inventory_set_listener(app_data->inventory, on_inventory_changed, app_data);
+    end_inventory_change(app_data);
+    refresh_tree_view(app_data);
+    update_totals(app_data);
+    update_reorder_view(app_data);
+    
+    if (loaded) {
         clear_input_fields(app_data);
         update_status(app_data, "📂 StockFlow: Inventory loaded successfully!");
         show_info_dialog(app_data->window, "✅ Welcome Back!\n\nYour inventory has been loaded from 'inventory.csv'.\nStockFlow is ready for action!");
     } else {
         show_error_dialog(app_data->window, "❌ Load Failed\n\nUnable to load inventory file. Please check if 'inventory.csv' exists.");
     }
-}
\ No newline at end of file
+}
+// Performance view columns
+enum {
+    PERF_COL_OP = 0,
+    PERF_COL_COUNT,
+    PERF_COL_MEAN,
+    PERF_COL_P50,
+    PERF_COL_P99,
+    PERF_COL_MAX,
+    PERF_COL_BYTES,
+    PERF_NUM_COLS
+};
+
+static void refresh_performance_view(AppData *app_data) {
+    GtkListStore *store = app_data->performance_store;
+    gtk_list_store_clear(store);
+    
+    MetricHistogram histogram;
+    for (int op = 0; op < METRIC_OP_COUNT; op++) {
+        metrics_get((MetricOp)op, &histogram);
+        double mean = histogram.count > 0 ? (double)histogram.total_ns / (double)histogram.count : 0.0;
+        char count[32], mean_us[32], p50_us[32], p99_us[32], max_us[32], bytes[32];
+        snprintf(count, sizeof(count), "%llu", (unsigned long long)histogram.count);
+        snprintf(mean_us, sizeof(mean_us), "%.1f", mean / 1e3);
+        snprintf(p50_us, sizeof(p50_us), "%.1f", metrics_percentile(&histogram, 0.50) / 1e3);
+        snprintf(p99_us, sizeof(p99_us), "%.1f", metrics_percentile(&histogram, 0.99) / 1e3);
+        snprintf(max_us, sizeof(max_us), "%.1f", histogram.max_ns / 1e3);
+        snprintf(bytes, sizeof(bytes), "%llu", (unsigned long long)histogram.bytes);
+        
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, PERF_COL_OP, metrics_op_name((MetricOp)op), PERF_COL_COUNT, count,
+                           PERF_COL_MEAN, mean_us, PERF_COL_P50, p50_us, PERF_COL_P99, p99_us,
+                           PERF_COL_MAX, max_us, PERF_COL_BYTES, bytes, -1);
+    }
+}
+
+static gboolean on_performance_refresh(gpointer data) {
+    refresh_performance_view((AppData *)data);
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_performance_reset_clicked(GtkWidget *widget, gpointer data) {
+    (void)widget;
+    metrics_reset();
+    refresh_performance_view((AppData *)data);
+}
+
+static void on_performance_window_destroy(GtkWidget *widget, gpointer data) {
+    (void)widget;
+    AppData *app_data = (AppData *)data;
+    g_source_remove(app_data->performance_timeout);
+    g_object_unref(app_data->performance_store);
+    app_data->performance_timeout = 0;
+    app_data->performance_store = NULL;
+    app_data->performance_window = NULL;
+}
+
+// Latency per core operation, live while the window is open
+void on_performance_clicked(GtkWidget *widget, gpointer data) {
+    (void)widget;
+    AppData *app_data = (AppData *)data;
+    if (app_data->performance_window) {
+        gtk_window_present(GTK_WINDOW(app_data->performance_window));
+        return;
+    }
+    
+    GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(window), "StockFlow - Performance");
+    gtk_window_set_transient_for(GTK_WINDOW(window), GTK_WINDOW(app_data->window));
+    gtk_window_set_default_size(GTK_WINDOW(window), 720, 360);
+    
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
+    gtk_container_set_border_width(GTK_CONTAINER(vbox), 12);
+    gtk_container_add(GTK_CONTAINER(window), vbox);
+    
+    const char *caption = metrics_enabled()
+        ? "Latency in microseconds since startup or the last reset"
+        : "Metrics were compiled out (built with METRICS=0)";
+    GtkWidget *caption_label = gtk_label_new(caption);
+    gtk_widget_set_halign(caption_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(vbox), caption_label, FALSE, FALSE, 0);
+    
+    app_data->performance_store = gtk_list_store_new(PERF_NUM_COLS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                                      G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget *tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(app_data->performance_store));
+    static const char *titles[PERF_NUM_COLS] = {"Operation", "Count", "Mean", "p50", "p99", "Max", "Bytes"};
+    for (int i = 0; i < PERF_NUM_COLS; i++) {
+        GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+        if (i != PERF_COL_OP) {
+            g_object_set(renderer, "xalign", 1.0, NULL);
+        }
+        GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL);
+        gtk_tree_view_column_set_expand(column, TRUE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(tree_view), column);
+    }
+    
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scrolled), tree_view);
+    gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+    
+    GtkWidget *reset_button = gtk_button_new_with_label("Reset");
+    add_css_class(reset_button, "secondary-button");
+    gtk_widget_set_halign(reset_button, GTK_ALIGN_END);
+    g_signal_connect(reset_button, "clicked", G_CALLBACK(on_performance_reset_clicked), app_data);
+    gtk_box_pack_start(GTK_BOX(vbox), reset_button, FALSE, FALSE, 0);
+    
+    app_data->performance_window = window;
+    app_data->performance_timeout = g_timeout_add(PERFORMANCE_REFRESH_MS, on_performance_refresh, app_data);
+    g_signal_connect(window, "destroy", G_CALLBACK(on_performance_window_destroy), app_data);
+    refresh_performance_view(app_data);
+    gtk_widget_show_all(window);
+}
+
+// Reorder view columns
+enum {
+    REORDER_COL_ID = 0,
+    REORDER_COL_NAME,
+    REORDER_COL_QUANTITY,
+    REORDER_COL_LEVEL,
+    REORDER_COL_SHORTFALL,
+    REORDER_NUM_COLS
+};
+
+// Reads the top of the inventory's reorder heap, so refreshing after every
+// edit costs the same however many items there are
+void update_reorder_view(AppData *app_data) {
+    GtkListStore *store = app_data->reorder_store;
+    if (!store) {
+        return;
+    }
+    gtk_list_store_clear(store);
+    
+    int ids[REORDER_VIEW_LIMIT];
+    int count = inventory_reorder_list(app_data->inventory, ids, REORDER_VIEW_LIMIT);
+    for (int i = 0; i < count; i++) {
+        InventoryItem item;
+        inventory_get_item(app_data->inventory, ids[i], &item);
+        
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, REORDER_COL_ID, item.id, REORDER_COL_NAME, item.name,
+                           REORDER_COL_QUANTITY, item.quantity, REORDER_COL_LEVEL, item.reorder_level,
+                           REORDER_COL_SHORTFALL, item.reorder_level - item.quantity, -1);
+    }
+}
+
+static void on_reorder_window_destroy(GtkWidget *widget, gpointer data) {
+    (void)widget;
+    AppData *app_data = (AppData *)data;
+    g_object_unref(app_data->reorder_store);
+    app_data->reorder_store = NULL;
+    app_data->reorder_window = NULL;
+}
+
+// Items below their reorder level, largest shortfall first; kept current
+// by on_inventory_changed while the window is open
+void on_reorder_clicked(GtkWidget *widget, gpointer data) {
+    (void)widget;
+    AppData *app_data = (AppData *)data;
+    if (app_data->reorder_window) {
+        gtk_window_present(GTK_WINDOW(app_data->reorder_window));
+        return;
+    }
+    
+    GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(window), "StockFlow - Reorder");
+    gtk_window_set_transient_for(GTK_WINDOW(window), GTK_WINDOW(app_data->window));
+    gtk_window_set_default_size(GTK_WINDOW(window), 640, 420);
+    
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
+    gtk_container_set_border_width(GTK_CONTAINER(vbox), 12);
+    gtk_container_add(GTK_CONTAINER(window), vbox);
+    
+    GtkWidget *caption_label = gtk_label_new("Items with fewer units than their reorder level");
+    gtk_widget_set_halign(caption_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(vbox), caption_label, FALSE, FALSE, 0);
+    
+    app_data->reorder_store = gtk_list_store_new(REORDER_NUM_COLS, G_TYPE_INT, G_TYPE_STRING, G_TYPE_INT,
+                                                  G_TYPE_INT, G_TYPE_INT);
+    GtkWidget *tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(app_data->reorder_store));
+    static const char *titles[REORDER_NUM_COLS] = {"ID", "Name", "Quantity", "Reorder Level", "Shortfall"};
+    for (int i = 0; i < REORDER_NUM_COLS; i++) {
+        GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+        if (i != REORDER_COL_NAME) {
+            g_object_set(renderer, "xalign", 1.0, NULL);
+        }
+        GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL);
+        gtk_tree_view_column_set_expand(column, i == REORDER_COL_NAME);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(tree_view), column);
+    }
+    
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scrolled), tree_view);
+    gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+    
+    app_data->reorder_window = window;
+    g_signal_connect(window, "destroy", G_CALLBACK(on_reorder_window_destroy), app_data);
+    update_reorder_view(app_data);
+    gtk_widget_show_all(window);
+}
+
+gboolean on_metrics_dump_timeout(gpointer data) {
+    AppData *app_data = (AppData *)data;
+    if (!metrics_write_file(app_data->metrics_filename)) {
+        fprintf(stderr, "StockFlow: cannot write metrics to %s\n", app_data->metrics_filename);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Publishes the inventory as it is now and writes that version on the
+// export worker; editing carries on meanwhile, since the worker never
+// touches the live inventory
+void on_export_clicked(GtkWidget *widget, gpointer data) {
+    (void)widget;
+    AppData *app_data = (AppData *)data;
+    if (app_data->exporting) {
+        update_status(app_data, "📤 StockFlow: An export is already in progress...");
+        return;
+    }
+    
+    if (!inventory_publisher_publish(app_data->publisher, app_data->inventory)) {
+        show_error_dialog(app_data->window, "❌ Export Failed\n\nNot enough memory to prepare the export.");
+        return;
+    }
+    if (!export_worker_start(&app_data->export_worker, app_data->publisher, "inventory_export.csv",
+                             on_export_finished, app_data)) {
+        show_error_dialog(app_data->window, "❌ Export Failed\n\nUnable to start the export.");
+        return;
+    }
+    app_data->exporting = true;
+    update_status(app_data, "📤 StockFlow: Exporting inventory...");
+}
@@ -0,0 +1,174 @@
+#include "id_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+
+#define ID_INDEX_MIN_CAPACITY 16
+
+// Fibonacci hashing: the top bits of the product depend on every bit of the
+// id, so sequential ids and ids on a power-of-two stride both spread out
+static int id_index_bucket(int id, int shift) {
+    uint32_t hash = (uint32_t)id * 2654435769u;
+    return (int)(hash >> shift);
+}
+
+static int id_index_shift(int capacity) {
+    int shift = 32;
+    while (capacity > 1) {
+        capacity >>= 1;
+        shift--;
+    }
+    return shift;
+}
+
+void id_index_init(IdIndex *index) {
+    index->entries = NULL;
+    index->capacity = 0;
+    index->shift = 32;
+    index->count = 0;
+}
+
+void id_index_free(IdIndex *index) {
+    free(index->entries);
+    id_index_init(index);
+}
+
+void id_index_clear(IdIndex *index) {
+    for (int i = 0; i < index->capacity; i++) {
+        index->entries[i].id = 0;
+    }
+    index->count = 0;
+}
+
+// Makes dst an exact copy of src, table layout included
+bool id_index_copy(IdIndex *dst, const IdIndex *src) {
+    IdIndexEntry *entries = NULL;
+    if (src->capacity > 0) {
+        entries = malloc((size_t)src->capacity * sizeof(IdIndexEntry));
+        if (!entries) {
+            return false;
+        }
+        memcpy(entries, src->entries, (size_t)src->capacity * sizeof(IdIndexEntry));
+    }
+    
+    free(dst->entries);
+    dst->entries = entries;
+    dst->capacity = src->capacity;
+    dst->shift = src->shift;
+    dst->count = src->count;
+    return true;
+}
+
+static void id_index_insert_entry(IdIndexEntry *entries, int capacity, int shift, int id, int slot) {
+    int bucket = id_index_bucket(id, shift);
+    while (entries[bucket].id != 0) {
+        bucket = (bucket + 1) & (capacity - 1);
+    }
+    entries[bucket].id = id;
+    entries[bucket].slot = slot;
+}
+
+static bool id_index_rehash(IdIndex *index, int new_capacity) {
+    IdIndexEntry *entries = calloc((size_t)new_capacity, sizeof(IdIndexEntry));
+    if (!entries) {
+        return false;
+    }
+    
+    int shift = id_index_shift(new_capacity);
+    for (int i = 0; i < index->capacity; i++) {
+        if (index->entries[i].id != 0) {
+            id_index_insert_entry(entries, new_capacity, shift, index->entries[i].id, index->entries[i].slot);
+        }
+    }
+    
+    free(index->entries);
+    index->entries = entries;
+    index->capacity = new_capacity;
+    index->shift = shift;
+    return true;
+}
+
+// Keeps the load factor at or below 1/2 so probe sequences stay short
+bool id_index_reserve(IdIndex *index, int min_count) {
+    if (min_count <= index->capacity / 2) {
+        return true;
+    }
+    if (min_count > INT_MAX / 4) {
+        return false;
+    }
+    
+    int new_capacity = (index->capacity > 0) ? index->capacity : ID_INDEX_MIN_CAPACITY;
+    while (new_capacity / 2 < min_count) {
+        new_capacity *= 2;
+    }
+    
+    return id_index_rehash(index, new_capacity);
+}
+
+bool id_index_put(IdIndex *index, int id, int slot) {
+    if (id <= 0 || !id_index_reserve(index, index->count + 1)) {
+        return false;
+    }
+    
+    int bucket = id_index_bucket(id, index->shift);
+    while (index->entries[bucket].id != 0) {
+        if (index->entries[bucket].id == id) {
+            index->entries[bucket].slot = slot;
+            return true;
+        }
+        bucket = (bucket + 1) & (index->capacity - 1);
+    }
+    
+    index->entries[bucket].id = id;
+    index->entries[bucket].slot = slot;
+    index->count++;
+    return true;
+}
+
+int id_index_get(const IdIndex *index, int id) {
+    if (id <= 0 || index->count == 0) {
+        return -1;
+    }
+    
+    int bucket = id_index_bucket(id, index->shift);
+    while (index->entries[bucket].id != 0) {
+        if (index->entries[bucket].id == id) {
+            return index->entries[bucket].slot;
+        }
+        bucket = (bucket + 1) & (index->capacity - 1);
+    }
+    return -1;
+}
+
+bool id_index_remove(IdIndex *index, int id) {
+    if (id <= 0 || index->count == 0) {
+        return false;
+    }
+    
+    int mask = index->capacity - 1;
+    int bucket = id_index_bucket(id, index->shift);
+    while (index->entries[bucket].id != id) {
+        if (index->entries[bucket].id == 0) {
+            return false;
+        }
+        bucket = (bucket + 1) & mask;
+    }
+    
+    // Backward-shift deletion: pull later members of the probe run into the hole
+    // so lookups never need tombstones
+    int hole = bucket;
+    int next = (hole + 1) & mask;
+    while (index->entries[next].id != 0) {
+        int home = id_index_bucket(index->entries[next].id, index->shift);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->entries[hole] = index->entries[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    
+    index->entries[hole].id = 0;
+    index->count--;
+    return true;
+}
@@ -1,152 +1,1688 @@
 #define _GNU_SOURCE  // Enable GNU extensions including strcasecmp
 #include "inventory.h"
-#include "utils.h"    // For string_contains_ignore_case function
+#include "utils.h"    // For StringMatcher
+#include "metrics.h"
+#include "parallel_sort.h"
+#include "radix_sort.h"
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <strings.h>  // For strcasecmp
+#include <limits.h>
+#include <math.h>     // For isfinite
+
+static const int inventory_low_stock_limits[INVENTORY_LOW_STOCK_LIMIT_COUNT] = INVENTORY_LOW_STOCK_LIMITS;
 
 void inventory_init(Inventory *inv) {
+    inv->ids = NULL;
+    inv->quantities = NULL;
+    inv->prices = NULL;
+    inv->reorder_levels = NULL;
+    inv->name_offsets = NULL;
+    inv->name_lengths = NULL;
+    inv->chunk_stamps = NULL;
+    name_heap_init(&inv->name_heap);
+    inv->count = 0;
+    inv->capacity = 0;
+    inv->next_id = 1;
+    id_index_init(&inv->id_index);
+    inv->order = NULL;
+    inv->order_pos = NULL;
+    inv->order_length = 0;
+    inv->order_live = NULL;
+    inv->holding_names = false;
+    for (int i = 0; i < SORT_CRITERIA_COUNT; i++) {
+        slot_tree_init(&inv->views[i].slots);
+        inv->views[i].built = false;
+    }
+    inv->sorted = false;
+    inv->sort_criteria = SORT_BY_ID;
+    inv->sort_ascending = true;
+    trigram_index_init(&inv->name_index);
+    inv->reorder_heap.slots = NULL;
+    inv->reorder_heap.positions = NULL;
+    inv->reorder_heap.length = 0;
+    inv->reorder_heap.capacity = 0;
+    inv->reorder_heap.built = false;
+    memset(&inv->totals, 0, sizeof(inv->totals));
+    inv->version = 0;
+    inv->saved_version = 0;
+    inv->listener = NULL;
+    inv->listener_data = NULL;
+}
+
+static void inventory_free_columns(Inventory *inv) {
+    free(inv->ids);
+    free(inv->quantities);
+    free(inv->prices);
+    free(inv->reorder_levels);
+    free(inv->name_offsets);
+    free(inv->name_lengths);
+    free(inv->chunk_stamps);
+    free(inv->order);
+    free(inv->order_pos);
+    free(inv->order_live);
+}
+
+void inventory_free(Inventory *inv) {
+    inventory_free_columns(inv);
+    name_heap_free(&inv->name_heap);
+    for (int i = 0; i < SORT_CRITERIA_COUNT; i++) {
+        slot_tree_free(&inv->views[i].slots);
+    }
+    id_index_free(&inv->id_index);
+    trigram_index_free(&inv->name_index);
+    free(inv->reorder_heap.slots);
+    free(inv->reorder_heap.positions);
+    inventory_init(inv);
+}
+
+// Drops all items but keeps the allocation for reuse (e.g. before a reload)
+void inventory_clear(Inventory *inv) {
+    inv->version++;
     inv->count = 0;
     inv->next_id = 1;
-    memset(inv->items, 0, sizeof(inv->items));
+    inv->order_length = 0;
+    if (inv->capacity > 0) {
+        memset(inv->order_live, 0, (size_t)inv->capacity * sizeof(int));
+    }
+    name_heap_clear(&inv->name_heap);
+    id_index_clear(&inv->id_index);
+    
+    // Views are rebuilt lazily, so a bulk reload does not pay for them per row
+    for (int i = 0; i < SORT_CRITERIA_COUNT; i++) {
+        slot_tree_free(&inv->views[i].slots);
+        inv->views[i].built = false;
+    }
+    inv->sorted = false;
+    trigram_index_free(&inv->name_index);
+    inv->reorder_heap.length = 0;
+    inv->reorder_heap.built = false;
+    memset(&inv->totals, 0, sizeof(inv->totals));
+}
+
+// A failed shrink keeps the old (larger) block, which is still big enough
+static bool inventory_resize_array(void **array, int old_capacity, int new_capacity, size_t element_size) {
+    void *resized = realloc(*array, (size_t)new_capacity * element_size);
+    if (!resized) {
+        return new_capacity <= old_capacity;
+    }
+    
+    *array = resized;
+    return true;
+}
+
+static int inventory_chunk_count(int slots) {
+    return (int)(((long long)slots + INVENTORY_CHUNK_ROWS - 1) / INVENTORY_CHUNK_ROWS);
+}
+
+// Records that a slot's row changed, for inventory_publisher_publish
+static void inventory_touch_slot(Inventory *inv, int slot) {
+    inv->chunk_stamps[slot / INVENTORY_CHUNK_ROWS] = inv->version;
+}
+
+static void inventory_touch_all(Inventory *inv) {
+    int chunks = inventory_chunk_count(inv->capacity);
+    for (int c = 0; c < chunks; c++) {
+        inv->chunk_stamps[c] = inv->version;
+    }
+}
+
+// order_live is a Fenwick tree over the capacity entries of order: element
+// i - 1 holds the live entries among the lowbit(i) ending at order[i - 1].
+// Deletes leave -1 holes in order; the tree turns a display position into
+// an index of order and back in O(log n) without squeezing them out.
+static void order_live_add(Inventory *inv, int index, int delta) {
+    for (int i = index + 1; i <= inv->capacity; i += i & -i) {
+        inv->order_live[i - 1] += delta;
+    }
+}
+
+// Live entries in order[0, index)
+static int order_live_count(const Inventory *inv, int index) {
+    int count = 0;
+    for (int i = index; i > 0; i -= i & -i) {
+        count += inv->order_live[i - 1];
+    }
+    return count;
+}
+
+// Index in order of the live entry at position, which must be below count
+static int order_live_find(const Inventory *inv, int position) {
+    int step = 1;
+    while (step <= inv->capacity / 2) {
+        step *= 2;
+    }
+    
+    int index = 0;
+    for (; step > 0; step /= 2) {
+        if (index + step <= inv->capacity && inv->order_live[index + step - 1] <= position) {
+            index += step;
+            position -= inv->order_live[index - 1];
+        }
+    }
+    return index;
+}
+
+// O(capacity); run whenever order is rewritten wholesale
+static void order_live_rebuild(Inventory *inv) {
+    for (int i = 0; i < inv->capacity; i++) {
+        inv->order_live[i] = i < inv->order_length && inv->order[i] >= 0;
+    }
+    for (int i = 1; i <= inv->capacity; i++) {
+        int parent = i + (i & -i);
+        if (parent <= inv->capacity) {
+            inv->order_live[parent - 1] += inv->order_live[i - 1];
+        }
+    }
+}
+
+// Every per-slot array shares one capacity; new_capacity must be positive
+static bool inventory_resize(Inventory *inv, int new_capacity) {
+    int old_chunks = inventory_chunk_count(inv->capacity);
+    int new_chunks = inventory_chunk_count(new_capacity);
+    if (!inventory_resize_array((void **)&inv->ids, inv->capacity, new_capacity, sizeof(int)) ||
+        !inventory_resize_array((void **)&inv->quantities, inv->capacity, new_capacity, sizeof(int)) ||
+        !inventory_resize_array((void **)&inv->prices, inv->capacity, new_capacity, sizeof(float)) ||
+        !inventory_resize_array((void **)&inv->reorder_levels, inv->capacity, new_capacity, sizeof(int)) ||
+        !inventory_resize_array((void **)&inv->name_offsets, inv->capacity, new_capacity, sizeof(uint32_t)) ||
+        !inventory_resize_array((void **)&inv->name_lengths, inv->capacity, new_capacity, sizeof(uint8_t)) ||
+        !inventory_resize_array((void **)&inv->order, inv->capacity, new_capacity, sizeof(int)) ||
+        !inventory_resize_array((void **)&inv->order_pos, inv->capacity, new_capacity, sizeof(int)) ||
+        !inventory_resize_array((void **)&inv->order_live, inv->capacity, new_capacity, sizeof(int)) ||
+        !inventory_resize_array((void **)&inv->chunk_stamps, old_chunks, new_chunks, sizeof(uint64_t))) {
+        return false;
+    }
+    
+    for (int c = old_chunks; c < new_chunks; c++) {
+        inv->chunk_stamps[c] = inv->version;
+    }
+    inv->capacity = new_capacity;
+    order_live_rebuild(inv);
+    return true;
+}
+
+bool inventory_reserve(Inventory *inv, int min_capacity) {
+    if (min_capacity <= inv->capacity) {
+        return true;
+    }
+    
+    // Grow geometrically so a run of single adds costs amortized O(1)
+    int new_capacity = (inv->capacity > 0) ? inv->capacity : INVENTORY_INITIAL_CAPACITY;
+    while (new_capacity < min_capacity) {
+        if (new_capacity > INT_MAX / 2) {
+            new_capacity = min_capacity;
+            break;
+        }
+        new_capacity *= 2;
+    }
+    
+    return inventory_resize(inv, new_capacity);
+}
+
+void inventory_shrink_to_fit(Inventory *inv) {
+    if (inv->count == inv->capacity) {
+        return;
+    }
+    
+    if (inv->count == 0) {
+        inventory_free_columns(inv);
+        name_heap_free(&inv->name_heap);
+        inv->ids = NULL;
+        inv->quantities = NULL;
+        inv->prices = NULL;
+        inv->reorder_levels = NULL;
+        inv->name_offsets = NULL;
+        inv->name_lengths = NULL;
+        inv->chunk_stamps = NULL;
+        inv->order = NULL;
+        inv->order_pos = NULL;
+        inv->order_live = NULL;
+        inv->capacity = 0;
+        inv->order_length = 0;
+        return;
+    }
+    
+    inventory_compact_order(inv);
+    inventory_resize(inv, inv->count);
+    name_heap_compact(&inv->name_heap, inv->name_offsets, inv->name_lengths, inv->count);
+}
+
+// Copies the rows, display order and id index into dst, which must be
+// initialized. Sort views and the search index are left to be rebuilt
+// lazily. On failure dst is left empty.
+bool inventory_copy(Inventory *dst, const Inventory *src) {
+    inventory_clear(dst);
+    if (src->capacity > 0 && !inventory_resize(dst, src->capacity)) {
+        return false;
+    }
+    if (!name_heap_assign(&dst->name_heap, src->name_heap.data, src->name_heap.used, src->name_heap.garbage) ||
+        !id_index_copy(&dst->id_index, &src->id_index)) {
+        inventory_clear(dst);
+        return false;
+    }
+    
+    if (src->count > 0) {
+        size_t count = (size_t)src->count;
+        memcpy(dst->ids, src->ids, count * sizeof(int));
+        memcpy(dst->quantities, src->quantities, count * sizeof(int));
+        memcpy(dst->prices, src->prices, count * sizeof(float));
+        memcpy(dst->reorder_levels, src->reorder_levels, count * sizeof(int));
+        memcpy(dst->name_offsets, src->name_offsets, count * sizeof(uint32_t));
+        memcpy(dst->name_lengths, src->name_lengths, count * sizeof(uint8_t));
+        memcpy(dst->order_pos, src->order_pos, count * sizeof(int));
+    }
+    if (src->order_length > 0) {
+        memcpy(dst->order, src->order, (size_t)src->order_length * sizeof(int));
+    }
+    
+    dst->count = src->count;
+    dst->order_length = src->order_length;
+    order_live_rebuild(dst);
+    dst->next_id = src->next_id;
+    dst->totals = src->totals;
+    dst->sorted = false;
+    dst->version = src->version;
+    dst->saved_version = src->saved_version;
+    inventory_touch_all(dst);
+    return true;
+}
+
+bool inventory_is_dirty(const Inventory *inv) {
+    return inv->version != inv->saved_version;
+}
+
+// Records that the contents as of version are on disk; a save that finishes
+// after newer edits leaves the inventory dirty
+void inventory_mark_saved(Inventory *inv, uint64_t version) {
+    if (version > inv->saved_version) {
+        inv->saved_version = version;
+    }
+}
+
+void inventory_set_listener(Inventory *inv, InventoryListener listener, void *user_data) {
+    inv->listener = listener;
+    inv->listener_data = user_data;
+}
+
+// Squeezes deleted entries out of the display order; O(order_length)
+void inventory_compact_order(Inventory *inv) {
+    if (inv->order_length == inv->count) {
+        return;
+    }
+    
+    int length = 0;
+    for (int i = 0; i < inv->order_length; i++) {
+        int slot = inv->order[i];
+        if (slot >= 0) {
+            inv->order[length] = slot;
+            inv->order_pos[slot] = length;
+            length++;
+        }
+    }
+    inv->order_length = length;
+    order_live_rebuild(inv);
+}
+
+const char* inventory_name_at(const Inventory *inv, int slot) {
+    return inv->name_heap.data + inv->name_offsets[slot];
+}
+
+int64_t inventory_price_cents(float price) {
+    double scaled = (double)price * 100.0;
+    if (!(scaled > -1e15 && scaled < 1e15)) {
+        return (scaled > 0) ? 1000000000000000LL : (scaled < 0) ? -1000000000000000LL : 0;
+    }
+    
+    // Half to even on the exact product, as the CSV writer rounds prices
+    double magnitude = scaled < 0 ? -scaled : scaled;
+    int64_t cents = (int64_t)magnitude;
+    double remainder = magnitude - (double)cents;
+    if (remainder > 0.5 || (remainder == 0.5 && (cents & 1))) {
+        cents++;
+    }
+    return scaled < 0 ? -cents : cents;
+}
+
+// Adds a row's share to the running totals (sign 1) or takes it out (-1).
+// The value sum wraps rather than overflows on absurd prices, and taking a
+// row out always cancels its own contribution exactly.
+static void inventory_totals_apply(InventoryTotals *totals, int quantity, float price, int sign) {
+    uint64_t value = (uint64_t)(int64_t)quantity * (uint64_t)inventory_price_cents(price);
+    totals->value_cents = (int64_t)((uint64_t)totals->value_cents + (sign > 0 ? value : -value));
+    totals->units += sign * (int64_t)quantity;
+    for (int i = 0; i < INVENTORY_LOW_STOCK_LIMIT_COUNT; i++) {
+        totals->low_stock_counts[i] += (quantity < inventory_low_stock_limits[i]) ? sign : 0;
+    }
+}
+
+// Orders two slots by one key alone
+static int inventory_compare_key(const Inventory *inv, SortCriteria criteria, int a, int b) {
+    switch (criteria) {
+        case SORT_BY_NAME:
+            return strcasecmp(inventory_name_at(inv, a), inventory_name_at(inv, b));
+        case SORT_BY_QUANTITY:
+            return (inv->quantities[a] > inv->quantities[b]) - (inv->quantities[a] < inv->quantities[b]);
+        case SORT_BY_PRICE:
+            return (inv->prices[a] > inv->prices[b]) - (inv->prices[a] < inv->prices[b]);
+        default:
+            return (inv->ids[a] > inv->ids[b]) - (inv->ids[a] < inv->ids[b]);
+    }
+}
+
+// Orders two slots by the criteria's key, then by id so that every view is
+// a strict total order and entries can be found by binary search
+static int inventory_compare_slots(const Inventory *inv, SortCriteria criteria, int a, int b) {
+    int result = inventory_compare_key(inv, criteria, a, b);
+    if (result == 0 && criteria != SORT_BY_ID) {
+        result = (inv->ids[a] > inv->ids[b]) - (inv->ids[a] < inv->ids[b]);
+    }
+    return result;
+}
+
+// A multi-key order, passed to parallel_sort as its context
+typedef struct {
+    const Inventory *inv;
+    const InventorySortKey *keys;
+    int key_count;
+} InventoryKeyOrder;
+
+static int inventory_compare_keys(const void *context, int a, int b) {
+    const InventoryKeyOrder *order = context;
+    for (int k = 0; k < order->key_count; k++) {
+        int result = inventory_compare_key(order->inv, order->keys[k].criteria, a, b);
+        if (result != 0) {
+            return order->keys[k].ascending ? result : -result;
+        }
+    }
+    return 0;
+}
+
+// A view's order, passed to its slot tree as the comparison context
+typedef struct {
+    const Inventory *inv;
+    SortCriteria criteria;
+} SortedViewOrder;
+
+static int sorted_view_compare(const void *context, int a, int b) {
+    const SortedViewOrder *order = context;
+    return inventory_compare_slots(order->inv, order->criteria, a, b);
+}
+
+// Position of slot in the view, or -1
+static int sorted_view_find(const Inventory *inv, SortCriteria criteria, int slot) {
+    SortedViewOrder order = {inv, criteria};
+    return slot_tree_rank(&inv->views[criteria].slots, slot, sorted_view_compare, &order);
+}
+
+// Frees a view; it is built again on its next use
+static void sorted_view_drop(Inventory *inv, SortCriteria criteria) {
+    slot_tree_free(&inv->views[criteria].slots);
+    inv->views[criteria].built = false;
+    if (inv->sorted && inv->sort_criteria == criteria) {
+        inv->sorted = false;
+    }
+}
+
+// Display positions [first, first + count) of the current sorted view;
+// views are stored ascending, so descending reads the mirrored run backwards
+static void sorted_view_read(const Inventory *inv, int first, int count, int *slots) {
+    const SlotTree *tree = &inv->views[inv->sort_criteria].slots;
+    if (inv->sort_ascending) {
+        slot_tree_read(tree, first, count, slots);
+        return;
+    }
+    
+    slot_tree_read(tree, inv->count - first - count, count, slots);
+    for (int i = 0, j = count - 1; i < j; i++, j--) {
+        int slot = slots[i];
+        slots[i] = slots[j];
+        slots[j] = slot;
+    }
+}
+
+// Below this many slots, clearing and summing 2048-entry histograms costs
+// more than the comparisons it saves
+#define INVENTORY_RADIX_MIN_ITEMS 2048
+
+static uint32_t inventory_radix_key(const Inventory *inv, InventorySortKey key, int slot) {
+    switch (key.criteria) {
+        case SORT_BY_QUANTITY:
+            return radix_key_int(inv->quantities[slot], key.ascending);
+        case SORT_BY_PRICE:
+            return radix_key_float(inv->prices[slot], key.ascending);
+        default:
+            return radix_key_int(inv->ids[slot], key.ascending);
+    }
+}
+
+// Stable sort of slots by keys. Numeric keys are radix sorted as (key, slot)
+// pairs, two 32-bit keys to a 64-bit pair key, starting from the least
+// significant pair; a name key needs the comparison sort.
+static bool inventory_sort_slots_by_keys(const Inventory *inv, const InventorySortKey *keys, int key_count,
+                                         int *slots, int n) {
+    bool numeric = n >= INVENTORY_RADIX_MIN_ITEMS;
+    for (int k = 0; k < key_count; k++) {
+        numeric = numeric && keys[k].criteria != SORT_BY_NAME;
+    }
+    if (!numeric) {
+        InventoryKeyOrder order = {inv, keys, key_count};
+        return parallel_sort(slots, n, inventory_compare_keys, &order);
+    }
+    
+    uint64_t *radix_keys = malloc((size_t)n * sizeof(uint64_t));
+    if (!radix_keys) {
+        return false;
+    }
+    for (int last = key_count; last > 0; last -= 2) {
+        int first = (last >= 2) ? last - 2 : 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t key = inventory_radix_key(inv, keys[first], slots[i]);
+            if (last - first == 2) {
+                key = key << 32 | inventory_radix_key(inv, keys[first + 1], slots[i]);
+            }
+            radix_keys[i] = key;
+        }
+        if (!radix_sort_pairs(radix_keys, slots, n)) {
+            free(radix_keys);
+            return false;
+        }
+    }
+    free(radix_keys);
+    return true;
+}
+
+// Sorts slots into view order for criteria: the key, then id
+static bool inventory_sort_view_slots(const Inventory *inv, SortCriteria criteria, int *slots, int n) {
+    InventorySortKey keys[2] = {{criteria, true}, {SORT_BY_ID, true}};
+    return inventory_sort_slots_by_keys(inv, keys, criteria == SORT_BY_ID ? 1 : 2, slots, n);
+}
+
+static bool sorted_view_build(Inventory *inv, SortCriteria criteria) {
+    SortedView *view = &inv->views[criteria];
+    if (view->built) {
+        return true;
+    }
+    
+    int *slots = malloc((size_t)(inv->count > 0 ? inv->count : 1) * sizeof(int));
+    if (!slots) {
+        return false;
+    }
+    for (int i = 0; i < inv->count; i++) {
+        slots[i] = i;
+    }
+    
+    view->built = inventory_sort_view_slots(inv, criteria, slots, inv->count) &&
+                  slot_tree_assign(&view->slots, slots, inv->count);
+    free(slots);
+    return view->built;
+}
+
+// Each change to a view descends its tree once: O(log n) comparisons and a
+// shift within a single leaf of at most SLOT_TREE_LEAF_SLOTS entries, however
+// large the catalog. A view that cannot grow is dropped and rebuilt on its
+// next use.
+static void sorted_view_insert(Inventory *inv, SortCriteria criteria, int slot) {
+    SortedViewOrder order = {inv, criteria};
+    if (!slot_tree_insert(&inv->views[criteria].slots, slot, sorted_view_compare, &order)) {
+        sorted_view_drop(inv, criteria);
+    }
+}
+
+// Must run while slot still holds the row's current key
+static void sorted_view_remove(Inventory *inv, SortCriteria criteria, int slot) {
+    SortedViewOrder order = {inv, criteria};
+    slot_tree_remove(&inv->views[criteria].slots, slot, sorted_view_compare, &order);
+}
+
+// Re-points the entry for a row that moved from one slot to another; the
+// row's key is unchanged, so its place in the view is too
+static void sorted_view_relocate(Inventory *inv, SortCriteria criteria, int from_slot, int to_slot) {
+    SortedViewOrder order = {inv, criteria};
+    slot_tree_replace(&inv->views[criteria].slots, from_slot, to_slot, sorted_view_compare, &order);
+}
+
+// Heap order: most below its reorder level first, ties by id
+static bool reorder_heap_less(const Inventory *inv, int a, int b) {
+    int64_t key_a = (int64_t)inv->quantities[a] - inv->reorder_levels[a];
+    int64_t key_b = (int64_t)inv->quantities[b] - inv->reorder_levels[b];
+    return key_a < key_b || (key_a == key_b && inv->ids[a] < inv->ids[b]);
+}
+
+static void reorder_heap_place(ReorderHeap *heap, int pos, int slot) {
+    heap->slots[pos] = slot;
+    heap->positions[slot] = pos;
+}
+
+static void reorder_heap_sift_up(Inventory *inv, int pos) {
+    ReorderHeap *heap = &inv->reorder_heap;
+    int slot = heap->slots[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!reorder_heap_less(inv, slot, heap->slots[parent])) {
+            break;
+        }
+        reorder_heap_place(heap, pos, heap->slots[parent]);
+        pos = parent;
+    }
+    reorder_heap_place(heap, pos, slot);
+}
+
+static void reorder_heap_sift_down(Inventory *inv, int pos) {
+    ReorderHeap *heap = &inv->reorder_heap;
+    int slot = heap->slots[pos];
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= heap->length) {
+            break;
+        }
+        if (child + 1 < heap->length && reorder_heap_less(inv, heap->slots[child + 1], heap->slots[child])) {
+            child++;
+        }
+        if (!reorder_heap_less(inv, heap->slots[child], slot)) {
+            break;
+        }
+        reorder_heap_place(heap, pos, heap->slots[child]);
+        pos = child;
+    }
+    reorder_heap_place(heap, pos, slot);
+}
+
+// Both arrays hold one entry per slot, so they grow with the inventory
+static bool reorder_heap_reserve(ReorderHeap *heap, int min_capacity) {
+    if (min_capacity <= heap->capacity) {
+        return true;
+    }
+    
+    int new_capacity = (heap->capacity > 0) ? heap->capacity : INVENTORY_INITIAL_CAPACITY;
+    while (new_capacity < min_capacity) {
+        new_capacity = (new_capacity > INT_MAX / 2) ? min_capacity : new_capacity * 2;
+    }
+    
+    int *slots = realloc(heap->slots, (size_t)new_capacity * sizeof(int));
+    if (slots) {
+        heap->slots = slots;
+    }
+    int *positions = realloc(heap->positions, (size_t)new_capacity * sizeof(int));
+    if (positions) {
+        heap->positions = positions;
+    }
+    if (!slots || !positions) {
+        return false;
+    }
+    heap->capacity = new_capacity;
+    return true;
+}
+
+// Floyd's bottom-up heapify, O(n)
+static bool reorder_heap_build(Inventory *inv) {
+    ReorderHeap *heap = &inv->reorder_heap;
+    if (heap->built) {
+        return true;
+    }
+    if (!reorder_heap_reserve(heap, inv->count)) {
+        return false;
+    }
+    
+    for (int i = 0; i < inv->count; i++) {
+        reorder_heap_place(heap, i, i);
+    }
+    heap->length = inv->count;
+    for (int pos = heap->length / 2 - 1; pos >= 0; pos--) {
+        reorder_heap_sift_down(inv, pos);
+    }
+    heap->built = true;
+    return true;
+}
+
+// Like a view, a heap that cannot grow is dropped and rebuilt on its next use
+static void reorder_heap_insert(Inventory *inv, int slot) {
+    ReorderHeap *heap = &inv->reorder_heap;
+    if (!reorder_heap_reserve(heap, heap->length + 1)) {
+        heap->built = false;
+        heap->length = 0;
+        return;
+    }
+    reorder_heap_place(heap, heap->length++, slot);
+    reorder_heap_sift_up(inv, heap->length - 1);
+}
+
+// Restores heap order around a slot whose key just changed
+static void reorder_heap_update(Inventory *inv, int slot) {
+    int pos = inv->reorder_heap.positions[slot];
+    reorder_heap_sift_up(inv, pos);
+    reorder_heap_sift_down(inv, inv->reorder_heap.positions[slot]);
+}
+
+static void reorder_heap_remove(Inventory *inv, int slot) {
+    ReorderHeap *heap = &inv->reorder_heap;
+    int pos = heap->positions[slot];
+    int last = heap->slots[--heap->length];
+    if (pos < heap->length) {
+        reorder_heap_place(heap, pos, last);
+        reorder_heap_update(inv, last);
+    }
+}
+
+// Display position of a live slot; only computed for listeners
+static int inventory_position_of(Inventory *inv, int slot) {
+    if (inv->sorted) {
+        int pos = sorted_view_find(inv, inv->sort_criteria, slot);
+        return inv->sort_ascending ? pos : inv->count - 1 - pos;
+    }
+    
+    return order_live_count(inv, inv->order_pos[slot]);
+}
+
+static void inventory_notify(Inventory *inv, InventoryChangeType type, int id, int old_position, int new_position) {
+    InventoryChange change = {type, id, old_position, new_position};
+    inv->listener(&change, inv->listener_data);
+}
+
+// A name index that cannot grow is dropped and rebuilt by the next search
+static void inventory_index_name(Inventory *inv, int id, const char *name) {
+    if (inv->name_index.built && !trigram_index_add(&inv->name_index, id, name)) {
+        trigram_index_free(&inv->name_index);
+    }
+}
+
+static void inventory_unindex_name(Inventory *inv, int id, const char *name) {
+    if (inv->name_index.built) {
+        trigram_index_remove(&inv->name_index, id, name);
+    }
+}
+
+static size_t inventory_name_length(const char *name) {
+    size_t length = 0;
+    while (length < MAX_NAME_LENGTH - 1 && name[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+// Compacting rewrites every live name, so it only runs once half the heap is garbage
+static void inventory_maybe_compact_names(Inventory *inv) {
+    if (!inv->holding_names && name_heap_needs_compaction(&inv->name_heap)) {
+        name_heap_compact(&inv->name_heap, inv->name_offsets, inv->name_lengths, inv->count);
+    }
+}
+
+// Appends a row with the given id and brings every index up to date;
+// returns its slot, or -1 if memory ran out (nothing is changed then)
+static int inventory_append_row(Inventory *inv, int id, const char *name, int quantity, float price) {
+    if (inv->count == INT_MAX || !inventory_reserve(inv, inv->count + 1)) {
+        return -1;
+    }
+    
+    size_t length = inventory_name_length(name);
+    uint32_t offset;
+    if (!name_heap_append(&inv->name_heap, name, length, &offset)) {
+        return -1;
+    }
+    if (!id_index_put(&inv->id_index, id, inv->count)) {
+        name_heap_release(&inv->name_heap, length);
+        return -1;
+    }
+    
+    // order shares the columns' capacity, so if it is full it must hold deleted entries
+    if (inv->order_length == inv->capacity) {
+        inventory_compact_order(inv);
+    }
+    
+    int slot = inv->count++;
+    inv->version++;
+    inv->ids[slot] = id;
+    inv->quantities[slot] = quantity;
+    inv->prices[slot] = price;
+    inv->reorder_levels[slot] = 0;
+    inv->name_offsets[slot] = offset;
+    inv->name_lengths[slot] = (uint8_t)length;
+    inventory_touch_slot(inv, slot);
+    inv->order[inv->order_length] = slot;
+    order_live_add(inv, inv->order_length, 1);
+    inv->order_pos[slot] = inv->order_length++;
+    inventory_totals_apply(&inv->totals, quantity, price, 1);
+    
+    inventory_index_name(inv, id, inventory_name_at(inv, slot));
+    for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+        if (inv->views[c].built) {
+            sorted_view_insert(inv, c, slot);
+        }
+    }
+    if (inv->reorder_heap.built) {
+        reorder_heap_insert(inv, slot);
+    }
+    
+    if (inv->listener) {
+        inventory_notify(inv, INVENTORY_ITEM_ADDED, id, -1, inventory_position_of(inv, slot));
+    }
+    return slot;
 }
 
 int inventory_add_item(Inventory *inv, const char *name, int quantity, float price) {
-    if (inv->count >= MAX_ITEMS || !name || strlen(name) == 0) {
+    METRICS_START(start);
+    if (!name || strlen(name) == 0) {
         return -1;
     }
     
-    InventoryItem *item = &inv->items[inv->count];
-    item->id = inv->next_id++;
-    strncpy(item->name, name, MAX_NAME_LENGTH - 1);
-    item->name[MAX_NAME_LENGTH - 1] = '\0';
-    item->quantity = quantity;
-    item->price = price;
+    int id = inv->next_id;
+    if (inventory_append_row(inv, id, name, quantity, price) == -1) {
+        return -1;
+    }
     
-    inv->count++;
-    return item->id;
+    inv->next_id++;
+    METRICS_RECORD(METRIC_ADD, start, 0);
+    return id;
+}
+
+// Adds an item under an existing id (used when loading saved data)
+int inventory_insert_item(Inventory *inv, int id, const char *name, int quantity, float price) {
+    if (id <= 0 || !name || id_index_get(&inv->id_index, id) != -1) {
+        return -1;
+    }
+    
+    if (inventory_append_row(inv, id, name, quantity, price) == -1) {
+        return -1;
+    }
+    
+    if (id >= inv->next_id) {
+        inv->next_id = id + 1;
+    }
+    return id;
+}
+
+// Replaces the contents with the given rows, copying each column in one
+// block. Rows are checked first; a bad name or id leaves the inventory
+// untouched, while running out of memory or a repeated id leaves it empty.
+bool inventory_load_columns(Inventory *inv, const InventoryColumns *columns) {
+    int count = columns->count;
+    if (count < 0 || columns->names_size > UINT32_MAX) {
+        return false;
+    }
+    
+    int max_id = 0;
+    size_t live = 0;
+    for (int i = 0; i < count; i++) {
+        size_t offset = columns->name_offsets[i];
+        size_t length = columns->name_lengths[i];
+        if (columns->ids[i] <= 0 || length > MAX_NAME_LENGTH - 1 ||
+            offset + length >= columns->names_size || columns->names[offset + length] != '\0' ||
+            (columns->reorder_levels && columns->reorder_levels[i] < 0)) {
+            return false;
+        }
+        if (columns->ids[i] > max_id) {
+            max_id = columns->ids[i];
+        }
+        live += length + 1;
+    }
+    
+    inventory_clear(inv);
+    size_t garbage = columns->names_size > live ? columns->names_size - live : 0;
+    if (!inventory_reserve(inv, count) || !id_index_reserve(&inv->id_index, count) ||
+        !name_heap_assign(&inv->name_heap, columns->names, columns->names_size, garbage)) {
+        return false;
+    }
+    
+    if (count > 0) {
+        memcpy(inv->ids, columns->ids, (size_t)count * sizeof(int));
+        memcpy(inv->quantities, columns->quantities, (size_t)count * sizeof(int));
+        memcpy(inv->prices, columns->prices, (size_t)count * sizeof(float));
+        if (columns->reorder_levels) {
+            memcpy(inv->reorder_levels, columns->reorder_levels, (size_t)count * sizeof(int));
+        } else {
+            memset(inv->reorder_levels, 0, (size_t)count * sizeof(int));
+        }
+        memcpy(inv->name_offsets, columns->name_offsets, (size_t)count * sizeof(uint32_t));
+        memcpy(inv->name_lengths, columns->name_lengths, (size_t)count * sizeof(uint8_t));
+    }
+    for (int i = 0; i < count; i++) {
+        inv->order[i] = i;
+        inv->order_pos[i] = i;
+        id_index_put(&inv->id_index, inv->ids[i], i);  // Cannot fail after the reserve
+        inventory_totals_apply(&inv->totals, inv->quantities[i], inv->prices[i], 1);
+    }
+    
+    // A repeated id overwrites its first entry instead of adding one
+    if (inv->id_index.count != count) {
+        inventory_clear(inv);
+        return false;
+    }
+    
+    inv->count = count;
+    inv->order_length = count;
+    order_live_rebuild(inv);
+    inv->version++;
+    inventory_touch_all(inv);
+    inv->next_id = (columns->next_id > max_id) ? columns->next_id : max_id + 1;
+    return true;
 }
 
 bool inventory_update_item(Inventory *inv, int id, const char *name, int quantity, float price) {
-    InventoryItem *item = inventory_find_by_id(inv, id);
-    if (!item || !name || strlen(name) == 0) {
+    METRICS_START(start);
+    int slot = inventory_get_index_by_id(inv, id);
+    if (slot == -1 || !name || strlen(name) == 0) {
+        return false;
+    }
+    
+    // Only views whose key changes need to move the entry; the id view never does
+    size_t length = inventory_name_length(name);
+    bool changed[SORT_CRITERIA_COUNT] = {false};
+    changed[SORT_BY_NAME] = inv->name_lengths[slot] != length ||
+                            memcmp(inventory_name_at(inv, slot), name, length) != 0;
+    changed[SORT_BY_QUANTITY] = inv->quantities[slot] != quantity;
+    changed[SORT_BY_PRICE] = inv->prices[slot] != price;
+    
+    // A new name goes at the end of the heap; the old one becomes garbage
+    uint32_t offset = inv->name_offsets[slot];
+    if (changed[SORT_BY_NAME] && !name_heap_append(&inv->name_heap, name, length, &offset)) {
         return false;
     }
     
-    strncpy(item->name, name, MAX_NAME_LENGTH - 1);
-    item->name[MAX_NAME_LENGTH - 1] = '\0';
-    item->quantity = quantity;
-    item->price = price;
+    // Entries whose key changes leave their views while the old key is still
+    // in place and go back in under the new one
+    int old_position = inv->listener ? inventory_position_of(inv, slot) : -1;
+    bool moved[SORT_CRITERIA_COUNT];
+    for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+        moved[c] = changed[c] && inv->views[c].built;
+        if (moved[c]) {
+            sorted_view_remove(inv, c, slot);
+        }
+    }
+    
+    if (changed[SORT_BY_NAME]) {
+        inventory_unindex_name(inv, id, inventory_name_at(inv, slot));
+        name_heap_release(&inv->name_heap, inv->name_lengths[slot]);
+        inv->name_offsets[slot] = offset;
+        inv->name_lengths[slot] = (uint8_t)length;
+        inventory_index_name(inv, id, inventory_name_at(inv, slot));
+    }
+    inventory_totals_apply(&inv->totals, inv->quantities[slot], inv->prices[slot], -1);
+    inventory_totals_apply(&inv->totals, quantity, price, 1);
+    inv->quantities[slot] = quantity;
+    inv->prices[slot] = price;
+    inventory_touch_slot(inv, slot);
     
+    for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+        if (moved[c]) {
+            sorted_view_insert(inv, c, slot);
+        }
+    }
+    if (changed[SORT_BY_QUANTITY] && inv->reorder_heap.built) {
+        reorder_heap_update(inv, slot);
+    }
+    
+    inv->version++;
+    inventory_maybe_compact_names(inv);
+    
+    if (inv->listener) {
+        inventory_notify(inv, INVENTORY_ITEM_UPDATED, id, old_position, inventory_position_of(inv, slot));
+    }
+    METRICS_RECORD(METRIC_UPDATE, start, 0);
     return true;
 }
 
 bool inventory_delete_item(Inventory *inv, int id) {
+    METRICS_START(start);
     int index = inventory_get_index_by_id(inv, id);
     if (index == -1) {
         return false;
     }
     
-    // Shift remaining items down
-    for (int i = index; i < inv->count - 1; i++) {
-        inv->items[i] = inv->items[i + 1];
+    int old_position = inv->listener ? inventory_position_of(inv, index) : -1;
+    id_index_remove(&inv->id_index, id);
+    inventory_unindex_name(inv, id, inventory_name_at(inv, index));
+    name_heap_release(&inv->name_heap, inv->name_lengths[index]);
+    inv->order[inv->order_pos[index]] = -1;
+    order_live_add(inv, inv->order_pos[index], -1);
+    inventory_totals_apply(&inv->totals, inv->quantities[index], inv->prices[index], -1);
+    
+    // Fill the hole with the last row so nothing else moves (its name stays
+    // where it is in the heap); its display position is unchanged, only the
+    // slot it points at
+    int last = inv->count - 1;
+    for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+        if (inv->views[c].built) {
+            sorted_view_remove(inv, c, index);
+            if (index != last) {
+                sorted_view_relocate(inv, c, last, index);
+            }
+        }
     }
+    if (inv->reorder_heap.built) {
+        reorder_heap_remove(inv, index);
+        if (index != last) {
+            reorder_heap_place(&inv->reorder_heap, inv->reorder_heap.positions[last], index);
+        }
+    }
+    if (index != last) {
+        inv->ids[index] = inv->ids[last];
+        inv->quantities[index] = inv->quantities[last];
+        inv->prices[index] = inv->prices[last];
+        inv->reorder_levels[index] = inv->reorder_levels[last];
+        inv->name_offsets[index] = inv->name_offsets[last];
+        inv->name_lengths[index] = inv->name_lengths[last];
+        inv->order_pos[index] = inv->order_pos[last];
+        inv->order[inv->order_pos[index]] = index;
+        id_index_put(&inv->id_index, inv->ids[index], index);
+    }
+    inventory_touch_slot(inv, index);
+    inventory_touch_slot(inv, last);
     inv->count--;
+    inv->version++;
+    
+    // Compact once deleted entries outnumber live ones, keeping deletes amortized O(1)
+    int deleted = inv->order_length - inv->count;
+    if (deleted > inv->count && deleted >= INVENTORY_INITIAL_CAPACITY) {
+        inventory_compact_order(inv);
+    }
+    inventory_maybe_compact_names(inv);
     
+    if (inv->listener) {
+        inventory_notify(inv, INVENTORY_ITEM_REMOVED, id, old_position, -1);
+    }
+    METRICS_RECORD(METRIC_DELETE, start, 0);
     return true;
 }
 
-InventoryItem* inventory_find_by_id(Inventory *inv, int id) {
-    for (int i = 0; i < inv->count; i++) {
-        if (inv->items[i].id == id) {
-            return &inv->items[i];
+int inventory_get_index_by_id(Inventory *inv, int id) {
+    return id_index_get(&inv->id_index, id);
+}
+
+bool inventory_set_reorder_level(Inventory *inv, int id, int level) {
+    int slot = inventory_get_index_by_id(inv, id);
+    if (slot == -1 || level < 0) {
+        return false;
+    }
+    if (inv->reorder_levels[slot] == level) {
+        return true;
+    }
+    
+    inv->reorder_levels[slot] = level;
+    inventory_touch_slot(inv, slot);
+    if (inv->reorder_heap.built) {
+        reorder_heap_update(inv, slot);
+    }
+    inv->version++;
+    
+    if (inv->listener) {
+        int position = inventory_position_of(inv, slot);
+        inventory_notify(inv, INVENTORY_ITEM_UPDATED, id, position, position);
+    }
+    return true;
+}
+
+// The frontier of inventory_reorder_list: a small heap of positions in the
+// reorder heap, ordered by the entries they point at
+static bool reorder_frontier_less(const Inventory *inv, const int *frontier, int a, int b) {
+    return reorder_heap_less(inv, inv->reorder_heap.slots[frontier[a]], inv->reorder_heap.slots[frontier[b]]);
+}
+
+static void reorder_frontier_swap(int *frontier, int a, int b) {
+    int temp = frontier[a];
+    frontier[a] = frontier[b];
+    frontier[b] = temp;
+}
+
+static void reorder_frontier_push(const Inventory *inv, int *frontier, int *length, int pos) {
+    int i = (*length)++;
+    frontier[i] = pos;
+    while (i > 0 && reorder_frontier_less(inv, frontier, i, (i - 1) / 2)) {
+        reorder_frontier_swap(frontier, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static int reorder_frontier_pop(const Inventory *inv, int *frontier, int *length) {
+    int top = frontier[0];
+    frontier[0] = frontier[--(*length)];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= *length) {
+            break;
+        }
+        if (child + 1 < *length && reorder_frontier_less(inv, frontier, child + 1, child)) {
+            child++;
+        }
+        if (!reorder_frontier_less(inv, frontier, child, i)) {
+            break;
         }
+        reorder_frontier_swap(frontier, i, child);
+        i = child;
     }
-    return NULL;
+    return top;
 }
 
-int inventory_get_index_by_id(Inventory *inv, int id) {
+// Reads the top of the reorder heap without changing it: the next smallest
+// entry is always the root or a child of one already reported, so only
+// that frontier is kept in order, never more than one entry per result
+// plus one
+int inventory_reorder_list(Inventory *inv, int *ids, int max_results) {
+    if (max_results <= 0) {
+        return 0;
+    }
+    if (!reorder_heap_build(inv)) {
+        return -1;
+    }
+    const ReorderHeap *heap = &inv->reorder_heap;
+    int *frontier = malloc(((size_t)max_results + 1) * sizeof(int));
+    if (!frontier) {
+        return -1;
+    }
+    
+    int count = 0;
+    int frontier_length = 0;
+    if (heap->length > 0) {
+        reorder_frontier_push(inv, frontier, &frontier_length, 0);
+    }
+    while (frontier_length > 0 && count < max_results) {
+        int pos = reorder_frontier_pop(inv, frontier, &frontier_length);
+        int slot = heap->slots[pos];
+        if (inv->quantities[slot] >= inv->reorder_levels[slot]) {
+            break;  // Everything left is at or above its level
+        }
+        ids[count++] = inv->ids[slot];
+        for (int child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap->length; child++) {
+            reorder_frontier_push(inv, frontier, &frontier_length, child);
+        }
+    }
+    
+    free(frontier);
+    return count;
+}
+
+// Batches this small keep the views current operation by operation (a tree
+// descent each); larger ones merge all their changes in at the end
+#define INVENTORY_BATCH_MERGE_THRESHOLD 64
+
+// Quantity recorded for an id the batch deletes
+#define INVENTORY_BATCH_DELETED -2
+
+// Quantity of id as the operations checked so far leave it, or -1 if there
+// is no such item
+static int inventory_batch_quantity(const Inventory *inv, const IdIndex *pending, int id) {
+    if (id <= 0) {
+        return -1;
+    }
+    
+    int quantity = id_index_get(pending, id);
+    if (quantity != -1) {
+        return quantity == INVENTORY_BATCH_DELETED ? -1 : quantity;
+    }
+    int slot = id_index_get(&inv->id_index, id);
+    return slot == -1 ? -1 : inv->quantities[slot];
+}
+
+static bool inventory_batch_fields_valid(const InventoryOp *op) {
+    return op->name && op->name[0] != '\0' && op->quantity >= 0 && isfinite(op->price) && op->price >= 0.0f;
+}
+
+// Plays the batch against pending (id -> resulting quantity of every item it
+// touches) without changing inv. Counts the adds and the name bytes they and
+// the updates need; returns the number of failed operations.
+static int inventory_batch_check(const Inventory *inv, const InventoryOp *ops, int count,
+                                 InventoryOpResult *results, IdIndex *pending, int *add_count, size_t *name_bytes) {
+    int failed = 0;
+    int next_id = inv->next_id;
+    *add_count = 0;
+    *name_bytes = 0;
+    
+    for (int i = 0; i < count; i++) {
+        const InventoryOp *op = &ops[i];
+        int id = (op->type == INVENTORY_OP_ADD) ? next_id : op->id;
+        int quantity = (op->type == INVENTORY_OP_ADD) ? op->quantity : inventory_batch_quantity(inv, pending, id);
+        InventoryOpStatus status = INVENTORY_OP_OK;
+        
+        switch (op->type) {
+            case INVENTORY_OP_ADD:
+                status = (inventory_batch_fields_valid(op) && op->reorder_level >= 0) ? INVENTORY_OP_OK
+                                                                                      : INVENTORY_OP_INVALID;
+                break;
+            case INVENTORY_OP_UPDATE:
+                status = (quantity == -1) ? INVENTORY_OP_NOT_FOUND
+                       : !inventory_batch_fields_valid(op) ? INVENTORY_OP_INVALID : INVENTORY_OP_OK;
+                quantity = op->quantity;
+                break;
+            case INVENTORY_OP_DELETE:
+                status = (quantity == -1) ? INVENTORY_OP_NOT_FOUND : INVENTORY_OP_OK;
+                quantity = INVENTORY_BATCH_DELETED;
+                break;
+            case INVENTORY_OP_ADJUST_QUANTITY:
+                if (quantity == -1) {
+                    status = INVENTORY_OP_NOT_FOUND;
+                } else {
+                    long long adjusted = (long long)quantity + op->quantity;
+                    status = (adjusted < 0 || adjusted > INT_MAX) ? INVENTORY_OP_OUT_OF_RANGE : INVENTORY_OP_OK;
+                    quantity = (int)adjusted;
+                }
+                break;
+            default:
+                status = INVENTORY_OP_INVALID;
+                break;
+        }
+        
+        results[i].status = status;
+        results[i].id = id;
+        if (status != INVENTORY_OP_OK) {
+            failed++;
+            continue;
+        }
+        
+        // pending has room for every operation, so this cannot fail
+        id_index_put(pending, id, quantity);
+        if (op->type == INVENTORY_OP_ADD) {
+            next_id++;
+            (*add_count)++;
+        }
+        if (op->type == INVENTORY_OP_ADD || op->type == INVENTORY_OP_UPDATE) {
+            *name_bytes += inventory_name_length(op->name) + 1;
+        }
+    }
+    return failed;
+}
+
+// Gives the views kept current per operation room for inserts entries and
+// the reorder heap room for rows, so applying does not allocate for them;
+// one that cannot get it is dropped now and rebuilt on its next use
+static void inventory_batch_reserve_caches(Inventory *inv, int rows, int inserts, bool merge) {
+    for (int c = 0; c < SORT_CRITERIA_COUNT && !merge; c++) {
+        if (inv->views[c].built && !slot_tree_reserve(&inv->views[c].slots, inserts)) {
+            sorted_view_drop(inv, c);
+        }
+    }
+    if (inv->reorder_heap.built && !reorder_heap_reserve(&inv->reorder_heap, rows)) {
+        inv->reorder_heap.built = false;
+        inv->reorder_heap.length = 0;
+    }
+}
+
+// Rebuilds the frozen views, which hold ids in their old order: entries the
+// batch left alone keep their order, and the touched items that still exist
+// are sorted on their own and merged in. A view that cannot be rebuilt is
+// dropped and built again on its next use.
+static void inventory_batch_merge_views(Inventory *inv, const IdIndex *pending, int **frozen,
+                                        const int *frozen_length) {
+    int *touched = malloc((size_t)(pending->count > 0 ? pending->count : 1) * 2 * sizeof(int));
+    int *merged = malloc((size_t)(inv->count > 0 ? inv->count : 1) * sizeof(int));
+    int touched_count = 0;
+    for (int i = 0; touched && i < pending->capacity; i++) {
+        const IdIndexEntry *entry = &pending->entries[i];
+        // Deleted ids are left out
+        int slot = (entry->id != 0 && entry->slot != INVENTORY_BATCH_DELETED)
+                 ? id_index_get(&inv->id_index, entry->id) : -1;
+        if (slot != -1) {
+            touched[touched_count++] = slot;
+        }
+    }
+    
+    for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+        if (!frozen[c]) {
+            continue;
+        }
+        int *kept_slots = frozen[c];
+        int *moved = touched ? touched + touched_count : NULL;
+        if (!touched || !merged) {
+            sorted_view_drop(inv, c);
+            continue;
+        }
+        
+        int kept = 0;
+        for (int i = 0; i < frozen_length[c]; i++) {
+            int id = kept_slots[i];
+            if (id_index_get(pending, id) == -1) {
+                kept_slots[kept++] = id_index_get(&inv->id_index, id);
+            }
+        }
+        
+        memcpy(moved, touched, (size_t)touched_count * sizeof(int));
+        if (!inventory_sort_view_slots(inv, (SortCriteria)c, moved, touched_count)) {
+            sorted_view_drop(inv, c);
+            continue;
+        }
+        
+        int i = 0, j = 0, k = 0;
+        while (i < kept || j < touched_count) {
+            if (j == touched_count || (i < kept && inventory_compare_slots(inv, c, kept_slots[i], moved[j]) < 0)) {
+                merged[k++] = kept_slots[i++];
+            } else {
+                merged[k++] = moved[j++];
+            }
+        }
+        inv->views[c].built = slot_tree_assign(&inv->views[c].slots, merged, k);
+        if (!inv->views[c].built) {
+            sorted_view_drop(inv, c);
+        }
+    }
+    free(touched);
+    free(merged);
+}
+
+bool inventory_apply_batch(Inventory *inv, const InventoryOp *ops, int count, InventoryOpResult *results) {
+    for (int i = 0; i < count; i++) {
+        results[i].status = INVENTORY_OP_NO_MEMORY;
+        results[i].id = (ops[i].type == INVENTORY_OP_ADD) ? -1 : ops[i].id;
+    }
+    if (count <= 0) {
+        return true;
+    }
+    
+    IdIndex pending;
+    id_index_init(&pending);
+    int add_count = 0;
+    size_t name_bytes = 0;
+    bool reserved = id_index_reserve(&pending, count);
+    int failed = reserved ? inventory_batch_check(inv, ops, count, results, &pending, &add_count, &name_bytes) : 0;
+    
+    // Room for every new row and name up front, so applying does not
+    // allocate. Garbage names are dropped first, and compaction is held off
+    // until the end, since it shrinks the heap to what is live.
+    if (reserved && failed == 0) {
+        inventory_maybe_compact_names(inv);
+        reserved = add_count <= INT_MAX - inv->count &&
+                   inventory_reserve(inv, inv->count + add_count) &&
+                   id_index_reserve(&inv->id_index, inv->count + add_count) &&
+                   name_heap_reserve(&inv->name_heap, inv->name_heap.used + name_bytes);
+    }
+    if (!reserved || failed > 0) {
+        for (int i = 0; i < count; i++) {
+            if (!reserved) {
+                results[i].status = INVENTORY_OP_NO_MEMORY;
+            } else if (results[i].status == INVENTORY_OP_OK) {
+                results[i].status = INVENTORY_OP_SKIPPED;
+            }
+        }
+        id_index_free(&pending);
+        return false;
+    }
+    
+    // A large batch freezes the views as lists of ids (deletes move rows
+    // between slots) and sends one reset in place of per-item changes
+    bool merge = count >= INVENTORY_BATCH_MERGE_THRESHOLD;
+    int *frozen[SORT_CRITERIA_COUNT] = {NULL};
+    int frozen_length[SORT_CRITERIA_COUNT] = {0};
+    InventoryListener listener = inv->listener;
+    inventory_batch_reserve_caches(inv, inv->count + add_count, count, merge);
+    if (merge) {
+        for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+            SortedView *view = &inv->views[c];
+            if (!view->built) {
+                continue;
+            }
+            int length = view->slots.length;
+            if ((frozen[c] = malloc((size_t)(length > 0 ? length : 1) * sizeof(int))) == NULL) {
+                sorted_view_drop(inv, c);
+                continue;
+            }
+            slot_tree_read(&view->slots, 0, length, frozen[c]);
+            for (int i = 0; i < length; i++) {
+                frozen[c][i] = inv->ids[frozen[c][i]];
+            }
+            frozen_length[c] = length;
+            slot_tree_free(&view->slots);
+            view->built = false;
+        }
+        inv->listener = NULL;
+    }
+    
+    // Every operation was checked and everything it needs is reserved, so
+    // none of these can fail and the ids predicted for adds are the ones taken
+    inv->holding_names = true;
+    for (int i = 0; i < count; i++) {
+        const InventoryOp *op = &ops[i];
+        switch (op->type) {
+            case INVENTORY_OP_ADD:
+                inventory_add_item(inv, op->name, op->quantity, op->price);
+                if (op->reorder_level != 0) {
+                    inventory_set_reorder_level(inv, results[i].id, op->reorder_level);
+                }
+                break;
+            case INVENTORY_OP_UPDATE:
+                inventory_update_item(inv, op->id, op->name, op->quantity, op->price);
+                break;
+            case INVENTORY_OP_DELETE:
+                inventory_delete_item(inv, op->id);
+                break;
+            default: {
+                int slot = id_index_get(&inv->id_index, op->id);
+                inventory_update_item(inv, op->id, inventory_name_at(inv, slot),
+                                      inv->quantities[slot] + op->quantity, inv->prices[slot]);
+                break;
+            }
+        }
+    }
+    inv->holding_names = false;
+    inventory_maybe_compact_names(inv);
+    
+    if (merge) {
+        inventory_batch_merge_views(inv, &pending, frozen, frozen_length);
+        for (int c = 0; c < SORT_CRITERIA_COUNT; c++) {
+            free(frozen[c]);
+        }
+        inv->listener = listener;
+        if (listener) {
+            inventory_notify(inv, INVENTORY_ITEMS_RESET, -1, -1, -1);
+        }
+    }
+    id_index_free(&pending);
+    return true;
+}
+
+void inventory_read_slot(const Inventory *inv, int slot, InventoryItem *item) {
+    item->id = inv->ids[slot];
+    memcpy(item->name, inventory_name_at(inv, slot), (size_t)inv->name_lengths[slot] + 1);
+    item->quantity = inv->quantities[slot];
+    item->price = inv->prices[slot];
+    item->reorder_level = inv->reorder_levels[slot];
+}
+
+bool inventory_get_item(const Inventory *inv, int id, InventoryItem *item) {
+    METRICS_START(start);
+    int slot = id_index_get(&inv->id_index, id);
+    if (slot != -1) {
+        inventory_read_slot(inv, slot, item);
+    }
+    METRICS_RECORD(METRIC_FIND, start, 0);
+    return slot != -1;
+}
+
+const InventoryItem* inventory_find_by_id(Inventory *inv, int id) {
+    return inventory_get_item(inv, id, &inv->row) ? &inv->row : NULL;
+}
+
+int inventory_slot_at(Inventory *inv, int position) {
+    if (position < 0 || position >= inv->count) {
+        return -1;
+    }
+    
+    if (inv->sorted) {
+        const SlotTree *tree = &inv->views[inv->sort_criteria].slots;
+        return slot_tree_select(tree, inv->sort_ascending ? position : inv->count - 1 - position);
+    }
+    
+    if (inv->order_length == inv->count) {
+        return inv->order[position];
+    }
+    return inv->order[order_live_find(inv, position)];
+}
+
+void inventory_read_display(Inventory *inv, int first, int count, int *slots) {
+    if (inv->sorted) {
+        sorted_view_read(inv, first, count, slots);
+        return;
+    }
+    
+    if (inv->order_length == inv->count) {
+        memcpy(slots, inv->order + first, (size_t)count * sizeof(int));
+        return;
+    }
+    
+    // Find the first entry once, then step over deleted ones
+    int n = 0;
+    for (int i = order_live_find(inv, first); n < count; i++) {
+        if (inv->order[i] >= 0) {
+            slots[n++] = inv->order[i];
+        }
+    }
+}
+
+const InventoryItem* inventory_item_at(Inventory *inv, int position) {
+    int slot = inventory_slot_at(inv, position);
+    if (slot == -1) {
+        return NULL;
+    }
+    
+    inventory_read_slot(inv, slot, &inv->row);
+    return &inv->row;
+}
+
+double inventory_stock_value(const Inventory *inv) {
+    return (double)inv->totals.value_cents / 100.0;
+}
+
+int64_t inventory_stock_value_cents(const Inventory *inv) {
+    return inv->totals.value_cents;
+}
+
+int64_t inventory_total_units(const Inventory *inv) {
+    return inv->totals.units;
+}
+
+// Other thresholds scan one column, which streams at memory bandwidth
+int inventory_count_low_stock(const Inventory *inv, int threshold) {
+    for (int i = 0; i < INVENTORY_LOW_STOCK_LIMIT_COUNT; i++) {
+        if (inventory_low_stock_limits[i] == threshold) {
+            return inv->totals.low_stock_counts[i];
+        }
+    }
+    
+    int count = 0;
     for (int i = 0; i < inv->count; i++) {
-        if (inv->items[i].id == id) {
-            return i;
+        count += inv->quantities[i] < threshold;
+    }
+    return count;
+}
+
+void inventory_sort(Inventory *inv, SortCriteria criteria, bool ascending) {
+    if (criteria < 0 || criteria >= SORT_CRITERIA_COUNT) {
+        return;
+    }
+    
+    METRICS_START(start);
+    // Views are stored ascending; descending just reads one from the back
+    if (sorted_view_build(inv, criteria)) {
+        inv->sorted = true;
+        inv->sort_criteria = criteria;
+        inv->sort_ascending = ascending;
+    }
+    METRICS_RECORD(METRIC_SORT, start, 0);
+}
+
+bool inventory_sort_by_keys(Inventory *inv, const InventorySortKey *keys, int key_count) {
+    if (key_count < 1 || key_count > INVENTORY_MAX_SORT_KEYS) {
+        return false;
+    }
+    for (int k = 0; k < key_count; k++) {
+        if (keys[k].criteria < 0 || keys[k].criteria >= SORT_CRITERIA_COUNT) {
+            return false;
         }
     }
-    return -1;
+    
+    METRICS_START(start);
+    // Sort the current display order in place, so ties keep it
+    if (inv->sorted) {
+        sorted_view_read(inv, 0, inv->count, inv->order);
+        inv->order_length = inv->count;
+    } else {
+        inventory_compact_order(inv);
+    }
+    
+    bool sorted = inventory_sort_slots_by_keys(inv, keys, key_count, inv->order, inv->count);
+    for (int i = 0; i < inv->count; i++) {
+        inv->order_pos[inv->order[i]] = i;
+    }
+    order_live_rebuild(inv);
+    if (sorted) {
+        inv->sorted = false;
+    }
+    METRICS_RECORD(METRIC_SORT, start, 0);
+    return sorted;
 }
 
-static int compare_by_id(const void *a, const void *b) {
-    const InventoryItem *item_a = (const InventoryItem *)a;
-    const InventoryItem *item_b = (const InventoryItem *)b;
-    return item_a->id - item_b->id;
+// Orders two slots the way the display currently lists them
+static int inventory_compare_display(const void *context, int a, int b) {
+    const Inventory *inv = context;
+    if (inv->sorted) {
+        int result = inventory_compare_slots(inv, inv->sort_criteria, a, b);
+        return inv->sort_ascending ? result : -result;
+    }
+    return (inv->order_pos[a] > inv->order_pos[b]) - (inv->order_pos[a] < inv->order_pos[b]);
 }
 
-static int compare_by_name(const void *a, const void *b) {
-    const InventoryItem *item_a = (const InventoryItem *)a;
-    const InventoryItem *item_b = (const InventoryItem *)b;
-    return strcasecmp(item_a->name, item_b->name);
+// Searches poll for cancellation this often (in rows or candidates)
+#define INVENTORY_SEARCH_CHECK_INTERVAL 4096
+
+// Matches beyond one in this many rows are put in display order by picking
+// them out of a walk over it, which polls for cancellation, instead of sorting
+#define INVENTORY_SEARCH_SORT_FRACTION 16
+
+static bool inventory_search_cancelled(InventoryCancelFunc cancelled, void *cancel_data, int i) {
+    return cancelled && i % INVENTORY_SEARCH_CHECK_INTERVAL == 0 && cancelled(cancel_data);
 }
 
-static int compare_by_quantity(const void *a, const void *b) {
-    const InventoryItem *item_a = (const InventoryItem *)a;
-    const InventoryItem *item_b = (const InventoryItem *)b;
-    return item_a->quantity - item_b->quantity;
+// Copies entries [first, first + count) of the display sequence to slots,
+// -1 standing for a deleted entry; the sequence runs to count when sorted,
+// else to order_length. Searches walk the display order a block of
+// INVENTORY_SEARCH_CHECK_INTERVAL entries at a time through this, polling
+// once per block. Only reads.
+static void inventory_search_read(const Inventory *inv, int first, int count, int *slots) {
+    if (inv->sorted) {
+        sorted_view_read(inv, first, count, slots);
+    } else {
+        memcpy(slots, inv->order + first, (size_t)count * sizeof(int));
+    }
 }
 
-static int compare_by_price(const void *a, const void *b) {
-    const InventoryItem *item_a = (const InventoryItem *)a;
-    const InventoryItem *item_b = (const InventoryItem *)b;
-    if (item_a->price < item_b->price) return -1;
-    if (item_a->price > item_b->price) return 1;
+// Returns 0 once the index is built, -1 if memory ran out or -2 if the
+// search was cancelled; a partial index is freed, so the next search starts over
+static int inventory_build_name_index(Inventory *inv, InventoryCancelFunc cancelled, void *cancel_data) {
+    if (inv->name_index.built) {
+        return 0;
+    }
+    
+    for (int i = 0; i < inv->count; i++) {
+        bool stop = inventory_search_cancelled(cancelled, cancel_data, i);
+        if (stop || !trigram_index_add(&inv->name_index, inv->ids[i], inventory_name_at(inv, i))) {
+            trigram_index_free(&inv->name_index);
+            return stop ? -2 : -1;
+        }
+    }
+    inv->name_index.built = true;
     return 0;
 }
 
-void inventory_sort(Inventory *inv, SortCriteria criteria, bool ascending) {
-    int (*compare_func)(const void *, const void *) = NULL;
+// Writes the ids of the matching slots (matches, match_count of them) in
+// display order. A few are sorted; many are marked and picked out of a walk
+// over the display order, so neither step runs long without polling.
+// Returns the number written, -1 if memory ran out or -2 if cancelled.
+static int inventory_search_order(Inventory *inv, int *matches, int match_count, int *ids, int max_results,
+                                  InventoryCancelFunc cancelled, void *cancel_data) {
+    int result_count = (match_count < max_results) ? match_count : max_results;
+    if (match_count <= inv->count / INVENTORY_SEARCH_SORT_FRACTION) {
+        if (!parallel_sort(matches, match_count, inventory_compare_display, inv)) {
+            return -1;
+        }
+        for (int i = 0; i < result_count; i++) {
+            ids[i] = inv->ids[matches[i]];
+        }
+        return result_count;
+    }
     
-    switch (criteria) {
-        case SORT_BY_ID:
-            compare_func = compare_by_id;
-            break;
-        case SORT_BY_NAME:
-            compare_func = compare_by_name;
-            break;
-        case SORT_BY_QUANTITY:
-            compare_func = compare_by_quantity;
-            break;
-        case SORT_BY_PRICE:
-            compare_func = compare_by_price;
-            break;
+    uint8_t *marked = calloc((size_t)inv->count / 8 + 1, 1);
+    if (!marked) {
+        return -1;
+    }
+    for (int i = 0; i < match_count; i++) {
+        marked[matches[i] / 8] |= (uint8_t)(1u << (matches[i] % 8));
     }
     
-    if (compare_func) {
-        qsort(inv->items, inv->count, sizeof(InventoryItem), compare_func);
-        
-        // Reverse if descending order
-        if (!ascending) {
-            for (int i = 0; i < inv->count / 2; i++) {
-                InventoryItem temp = inv->items[i];
-                inv->items[i] = inv->items[inv->count - 1 - i];
-                inv->items[inv->count - 1 - i] = temp;
+    int length = inv->sorted ? inv->count : inv->order_length;
+    int found = 0;
+    int block[INVENTORY_SEARCH_CHECK_INTERVAL];
+    for (int first = 0; first < length && found < result_count; first += INVENTORY_SEARCH_CHECK_INTERVAL) {
+        if (inventory_search_cancelled(cancelled, cancel_data, first)) {
+            free(marked);
+            return -2;
+        }
+        int n = (length - first < INVENTORY_SEARCH_CHECK_INTERVAL) ? length - first : INVENTORY_SEARCH_CHECK_INTERVAL;
+        inventory_search_read(inv, first, n, block);
+        for (int i = 0; i < n && found < result_count; i++) {
+            int slot = block[i];
+            if (slot != -1 && (marked[slot / 8] & (1u << (slot % 8)))) {
+                ids[found++] = inv->ids[slot];
             }
         }
     }
+    free(marked);
+    return found;
 }
 
-int inventory_search(Inventory *inv, const char *query, InventoryItem *results, int max_results) {
-    if (!query || strlen(query) == 0) {
-        // Return all items if no query
-        int count = (inv->count < max_results) ? inv->count : max_results;
-        memcpy(results, inv->items, count * sizeof(InventoryItem));
-        return count;
+// Answers the query from the trigram index: intersect posting lists, verify
+// each candidate, then put the matches in display order. Returns -1 when the
+// index cannot serve the query so the caller falls back to a scan, or -2 if
+// the search was cancelled.
+static int inventory_search_indexed(Inventory *inv, const char *query, int *ids, int max_results,
+                                    InventoryCancelFunc cancelled, void *cancel_data) {
+    if (strlen(query) < TRIGRAM_MIN_QUERY_LENGTH) {
+        return -1;
+    }
+    int built = inventory_build_name_index(inv, cancelled, cancel_data);
+    if (built < 0) {
+        return built;
+    }
+    
+    int *candidates;
+    int candidate_count = trigram_index_query(&inv->name_index, query, &candidates);
+    if (candidate_count < 0) {
+        return -1;
     }
     
+    // Trigram hits only suggest a match; keep candidates that really contain the query
+    StringMatcher matcher;
+    string_matcher_init(&matcher, query);
+    
+    int match_count = 0;
+    for (int i = 0; i < candidate_count; i++) {
+        if (inventory_search_cancelled(cancelled, cancel_data, i)) {
+            free(candidates);
+            return -2;
+        }
+        int slot = id_index_get(&inv->id_index, candidates[i]);
+        if (slot != -1 && string_matcher_find(&matcher, inventory_name_at(inv, slot), inv->name_lengths[slot])) {
+            candidates[match_count++] = slot;
+        }
+    }
+    
+    int result_count = inventory_search_order(inv, candidates, match_count, ids, max_results, cancelled, cancel_data);
+    free(candidates);
+    return result_count;
+}
+
+int inventory_search(Inventory *inv, const char *query, int *ids, int max_results,
+                     InventoryCancelFunc cancelled, void *cancel_data) {
+    METRICS_START(start);
+    bool match_all = !query || strlen(query) == 0;
+    
+    if (!match_all) {
+        int result_count = inventory_search_indexed(inv, query, ids, max_results, cancelled, cancel_data);
+        if (result_count != -1) {
+            METRICS_RECORD(METRIC_SEARCH, start, 0);
+            return result_count < 0 ? -1 : result_count;
+        }
+    }
+    
+    StringMatcher matcher;
+    string_matcher_init(&matcher, match_all ? "" : query);
     int result_count = 0;
-    for (int i = 0; i < inv->count && result_count < max_results; i++) {
-        if (string_contains_ignore_case(inv->items[i].name, query)) {
-            results[result_count++] = inv->items[i];
+    
+    // Short queries scan in display order. Deleted entries are skipped rather
+    // than compacted away, so the scan never writes to the display order.
+    int length = inv->sorted ? inv->count : inv->order_length;
+    int block[INVENTORY_SEARCH_CHECK_INTERVAL];
+    for (int first = 0; first < length && result_count < max_results; first += INVENTORY_SEARCH_CHECK_INTERVAL) {
+        if (inventory_search_cancelled(cancelled, cancel_data, first)) {
+            return -1;
+        }
+        int n = (length - first < INVENTORY_SEARCH_CHECK_INTERVAL) ? length - first : INVENTORY_SEARCH_CHECK_INTERVAL;
+        inventory_search_read(inv, first, n, block);
+        for (int i = 0; i < n && result_count < max_results; i++) {
+            int slot = block[i];
+            if (slot != -1 && (match_all || string_matcher_find(&matcher, inventory_name_at(inv, slot),
+                                                                 inv->name_lengths[slot]))) {
+                ids[result_count++] = inv->ids[slot];
+            }
         }
     }
     
+    METRICS_RECORD(METRIC_SEARCH, start, 0);
     return result_count;
 }
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "inventory_model.h"
+#include "gui.h"
+#include <string.h>
+
+struct _InventoryModel {
+    GObject parent;
+    Inventory *inventory;
+    int *ids;     // Filtered rows by id, or NULL to show every item
+    int length;   // Rows in ids
+    gint stamp;   // Changed on every reset so stale iters are rejected
+};
+
+static void inventory_model_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(InventoryModel, inventory_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, inventory_model_tree_model_init))
+
+int inventory_model_row_count(InventoryModel *model) {
+    return model->ids ? model->length : model->inventory->count;
+}
+
+bool inventory_model_is_filtered(InventoryModel *model) {
+    return model->ids != NULL;
+}
+
+// Resolves a row to its slot in the inventory; -1 if a filtered id has
+// since been deleted
+static int inventory_model_slot(InventoryModel *model, int position) {
+    if (model->ids) {
+        return inventory_get_index_by_id(model->inventory, model->ids[position]);
+    }
+    return inventory_slot_at(model->inventory, position);
+}
+
+static GtkTreeModelFlags inventory_model_get_flags(GtkTreeModel *tree_model) {
+    (void)tree_model;
+    return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint inventory_model_get_n_columns(GtkTreeModel *tree_model) {
+    (void)tree_model;
+    return NUM_COLS;
+}
+
+static GType inventory_model_get_column_type(GtkTreeModel *tree_model, gint column) {
+    (void)tree_model;
+    switch (column) {
+        case COL_ID: return G_TYPE_INT;
+        case COL_NAME: return G_TYPE_STRING;
+        case COL_QUANTITY: return G_TYPE_INT;
+        case COL_PRICE: return G_TYPE_FLOAT;
+        default: return G_TYPE_INVALID;
+    }
+}
+
+// Iters carry the row position, so lookups need no per-row allocation
+static gboolean inventory_model_make_iter(InventoryModel *model, GtkTreeIter *iter, int position) {
+    if (position < 0 || position >= inventory_model_row_count(model)) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+    iter->stamp = model->stamp;
+    iter->user_data = GINT_TO_POINTER(position);
+    return TRUE;
+}
+
+static gboolean inventory_model_get_iter(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreePath *path) {
+    if (gtk_tree_path_get_depth(path) != 1) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+    return inventory_model_make_iter(INVENTORY_MODEL(tree_model), iter, gtk_tree_path_get_indices(path)[0]);
+}
+
+static GtkTreePath *inventory_model_get_path(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    g_return_val_if_fail(iter->stamp == INVENTORY_MODEL(tree_model)->stamp, NULL);
+    return gtk_tree_path_new_from_indices(GPOINTER_TO_INT(iter->user_data), -1);
+}
+
+static void inventory_model_get_value(GtkTreeModel *tree_model, GtkTreeIter *iter, gint column, GValue *value) {
+    InventoryModel *model = INVENTORY_MODEL(tree_model);
+    g_value_init(value, inventory_model_get_column_type(tree_model, column));
+    g_return_if_fail(iter->stamp == model->stamp);
+    
+    int slot = inventory_model_slot(model, GPOINTER_TO_INT(iter->user_data));
+    if (slot == -1) {
+        return;
+    }
+    
+    const Inventory *inv = model->inventory;
+    switch (column) {
+        case COL_ID: g_value_set_int(value, inv->ids[slot]); break;
+        case COL_NAME: g_value_set_string(value, inventory_name_at(inv, slot)); break;
+        case COL_QUANTITY: g_value_set_int(value, inv->quantities[slot]); break;
+        case COL_PRICE: g_value_set_float(value, inv->prices[slot]); break;
+    }
+}
+
+static gboolean inventory_model_iter_next(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return inventory_model_make_iter(INVENTORY_MODEL(tree_model), iter, GPOINTER_TO_INT(iter->user_data) + 1);
+}
+
+static gboolean inventory_model_iter_previous(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return inventory_model_make_iter(INVENTORY_MODEL(tree_model), iter, GPOINTER_TO_INT(iter->user_data) - 1);
+}
+
+static gboolean inventory_model_iter_children(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *parent) {
+    if (parent) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+    return inventory_model_make_iter(INVENTORY_MODEL(tree_model), iter, 0);
+}
+
+static gboolean inventory_model_iter_has_child(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    (void)tree_model;
+    (void)iter;
+    return FALSE;
+}
+
+static gint inventory_model_iter_n_children(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return iter ? 0 : inventory_model_row_count(INVENTORY_MODEL(tree_model));
+}
+
+static gboolean inventory_model_iter_nth_child(GtkTreeModel *tree_model, GtkTreeIter *iter,
+                                               GtkTreeIter *parent, gint n) {
+    if (parent) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+    return inventory_model_make_iter(INVENTORY_MODEL(tree_model), iter, n);
+}
+
+static gboolean inventory_model_iter_parent(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *child) {
+    (void)tree_model;
+    (void)child;
+    iter->stamp = 0;
+    return FALSE;
+}
+
+static void inventory_model_tree_model_init(GtkTreeModelIface *iface) {
+    iface->get_flags = inventory_model_get_flags;
+    iface->get_n_columns = inventory_model_get_n_columns;
+    iface->get_column_type = inventory_model_get_column_type;
+    iface->get_iter = inventory_model_get_iter;
+    iface->get_path = inventory_model_get_path;
+    iface->get_value = inventory_model_get_value;
+    iface->iter_next = inventory_model_iter_next;
+    iface->iter_previous = inventory_model_iter_previous;
+    iface->iter_children = inventory_model_iter_children;
+    iface->iter_has_child = inventory_model_iter_has_child;
+    iface->iter_n_children = inventory_model_iter_n_children;
+    iface->iter_nth_child = inventory_model_iter_nth_child;
+    iface->iter_parent = inventory_model_iter_parent;
+}
+
+static void inventory_model_finalize(GObject *object) {
+    InventoryModel *model = INVENTORY_MODEL(object);
+    g_free(model->ids);
+    G_OBJECT_CLASS(inventory_model_parent_class)->finalize(object);
+}
+
+static void inventory_model_class_init(InventoryModelClass *klass) {
+    G_OBJECT_CLASS(klass)->finalize = inventory_model_finalize;
+}
+
+static void inventory_model_init(InventoryModel *model) {
+    model->inventory = NULL;
+    model->ids = NULL;
+    model->length = 0;
+    model->stamp = g_random_int();
+}
+
+InventoryModel *inventory_model_new(Inventory *inv) {
+    InventoryModel *model = g_object_new(INVENTORY_TYPE_MODEL, NULL);
+    model->inventory = inv;
+    return model;
+}
+
+void inventory_model_clear_filter(InventoryModel *model) {
+    g_free(model->ids);
+    model->ids = NULL;
+    model->length = 0;
+    model->stamp++;
+}
+
+void inventory_model_set_filter(InventoryModel *model, int *ids, int length) {
+    g_free(model->ids);
+    model->ids = ids;
+    model->length = length;
+    model->stamp++;
+}
+
+
+// Filter position of id, or -1; filters are search results, so a scan is
+// proportional to what is on screen rather than to the catalog
+static int inventory_model_filter_find(InventoryModel *model, int id) {
+    for (int i = 0; i < model->length; i++) {
+        if (model->ids[i] == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void inventory_model_emit_changed(InventoryModel *model, int position) {
+    GtkTreeIter iter;
+    if (inventory_model_make_iter(model, &iter, position)) {
+        GtkTreePath *path = gtk_tree_path_new_from_indices(position, -1);
+        gtk_tree_model_row_changed(GTK_TREE_MODEL(model), path, &iter);
+        gtk_tree_path_free(path);
+    }
+}
+
+// The row is already in place, so iters handed out before now are stale
+static void inventory_model_emit_inserted(InventoryModel *model, int position) {
+    model->stamp++;
+    GtkTreeIter iter;
+    if (inventory_model_make_iter(model, &iter, position)) {
+        GtkTreePath *path = gtk_tree_path_new_from_indices(position, -1);
+        gtk_tree_model_row_inserted(GTK_TREE_MODEL(model), path, &iter);
+        gtk_tree_path_free(path);
+    }
+}
+
+static void inventory_model_emit_deleted(InventoryModel *model, int position) {
+    model->stamp++;
+    GtkTreePath *path = gtk_tree_path_new_from_indices(position, -1);
+    gtk_tree_model_row_deleted(GTK_TREE_MODEL(model), path);
+    gtk_tree_path_free(path);
+}
+
+void inventory_model_apply_change(InventoryModel *model, const InventoryChange *change) {
+    if (model->ids) {
+        int position = inventory_model_filter_find(model, change->id);
+        if (position == -1) {
+            return;
+        }
+        
+        if (change->type == INVENTORY_ITEM_REMOVED) {
+            memmove(&model->ids[position], &model->ids[position + 1],
+                    (size_t)(model->length - position - 1) * sizeof(int));
+            model->length--;
+            inventory_model_emit_deleted(model, position);
+        } else if (change->type == INVENTORY_ITEM_UPDATED) {
+            inventory_model_emit_changed(model, position);
+        }
+        return;
+    }
+    
+    switch (change->type) {
+        case INVENTORY_ITEM_ADDED:
+            inventory_model_emit_inserted(model, change->new_position);
+            break;
+        case INVENTORY_ITEM_REMOVED:
+            inventory_model_emit_deleted(model, change->old_position);
+            break;
+        case INVENTORY_ITEM_UPDATED:
+            // A changed sort key moves the row; the view sees it leave and reappear
+            if (change->old_position == change->new_position) {
+                inventory_model_emit_changed(model, change->new_position);
+            } else {
+                inventory_model_emit_deleted(model, change->old_position);
+                inventory_model_emit_inserted(model, change->new_position);
+            }
+            break;
+        case INVENTORY_ITEMS_RESET:
+            break;  // Too many rows to signal; the owner reattaches the model
+    }
+}
+
+void inventory_model_filter_append(InventoryModel *model, int id) {
+    if (!model->ids) {
+        return;
+    }
+    
+    model->ids = g_renew(int, model->ids, model->length + 1);
+    model->ids[model->length++] = id;
+    inventory_model_emit_inserted(model, model->length - 1);
+}
\ No newline at end of file
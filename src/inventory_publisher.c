@@ -0,0 +1,341 @@
+#define _POSIX_C_SOURCE 200809L  // For pthreads and strcasecmp
+#include "inventory_publisher.h"
+#include "utils.h"  // For StringMatcher
+#include "parallel_sort.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>  // For strcasecmp
+
+static int publisher_chunk_count(int rows) {
+    return (int)(((long long)rows + INVENTORY_CHUNK_ROWS - 1) / INVENTORY_CHUNK_ROWS);
+}
+
+// Rows of a version held by chunk c
+static int publisher_chunk_rows(int count, int c) {
+    int rows = count - c * INVENTORY_CHUNK_ROWS;
+    return rows < INVENTORY_CHUNK_ROWS ? rows : INVENTORY_CHUNK_ROWS;
+}
+
+void inventory_publisher_init(InventoryPublisher *publisher) {
+    memset(publisher, 0, sizeof(*publisher));
+    publisher->epoch = 1;
+    pthread_mutex_init(&publisher->write_lock, NULL);
+}
+
+static void publisher_free_version(InventoryVersion *version) {
+    int chunks = publisher_chunk_count(version->count);
+    for (int c = 0; c < chunks; c++) {
+        if (version->chunks[c] && --version->chunks[c]->refs == 0) {
+            free(version->chunks[c]);
+        }
+        if (version->order[c] && --version->order[c]->refs == 0) {
+            free(version->order[c]);
+        }
+    }
+    free(version->chunks);
+    free(version->order);
+    free(version);
+}
+
+void inventory_publisher_free(InventoryPublisher *publisher) {
+    while (publisher->retired) {
+        InventoryVersion *next = publisher->retired->next_retired;
+        publisher_free_version(publisher->retired);
+        publisher->retired = next;
+    }
+    if (publisher->current) {
+        publisher_free_version(publisher->current);
+    }
+    pthread_mutex_destroy(&publisher->write_lock);
+    memset(publisher, 0, sizeof(*publisher));
+}
+
+// Copies slots [c * INVENTORY_CHUNK_ROWS, + rows) out of the inventory
+static InventoryChunk *publisher_copy_chunk(const Inventory *inv, int c, int rows) {
+    int first = c * INVENTORY_CHUNK_ROWS;
+    size_t names_size = 0;
+    for (int i = 0; i < rows; i++) {
+        names_size += (size_t)inv->name_lengths[first + i] + 1;
+    }
+    
+    InventoryChunk *chunk = malloc(sizeof(InventoryChunk) + names_size);
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->refs = 1;
+    memcpy(chunk->ids, inv->ids + first, (size_t)rows * sizeof(int));
+    memcpy(chunk->quantities, inv->quantities + first, (size_t)rows * sizeof(int));
+    memcpy(chunk->prices, inv->prices + first, (size_t)rows * sizeof(float));
+    memcpy(chunk->reorder_levels, inv->reorder_levels + first, (size_t)rows * sizeof(int));
+    memcpy(chunk->name_lengths, inv->name_lengths + first, (size_t)rows * sizeof(uint8_t));
+    
+    uint32_t offset = 0;
+    for (int i = 0; i < rows; i++) {
+        size_t length = inv->name_lengths[first + i];
+        chunk->name_offsets[i] = offset;
+        memcpy(chunk->names + offset, inventory_name_at(inv, first + i), length + 1);
+        offset += (uint32_t)length + 1;
+    }
+    return chunk;
+}
+
+// Builds the next version, sharing every chunk of previous that is still
+// current. Row chunks are known to be unchanged from the inventory's chunk
+// stamps; the display order has no stamps (sorting rewrites it wholesale),
+// so each order chunk is compared with the previous one instead.
+static InventoryVersion *publisher_build(const InventoryPublisher *publisher, Inventory *inv,
+                                         const InventoryVersion *previous) {
+    int count = inv->count;
+    int chunks = publisher_chunk_count(count);
+    InventoryVersion *version = calloc(1, sizeof(InventoryVersion));
+    if (!version) {
+        return NULL;
+    }
+    version->version = inv->version;
+    version->count = count;
+    version->next_id = inv->next_id;
+    version->totals = inv->totals;
+    version->chunks = calloc((size_t)(chunks > 0 ? chunks : 1), sizeof(InventoryChunk *));
+    version->order = calloc((size_t)(chunks > 0 ? chunks : 1), sizeof(InventoryOrderChunk *));
+    if (!version->chunks || !version->order) {
+        free(version->chunks);
+        free(version->order);
+        free(version);
+        return NULL;
+    }
+    
+    // A mutation stamps its chunks with the version from just before or
+    // just after it, so anything stamped since the previous version's own
+    // number may have changed
+    int previous_chunks = previous ? publisher_chunk_count(previous->count) : 0;
+    bool stamps_valid = previous && inv->version >= publisher->published_version;
+    int slots[INVENTORY_CHUNK_ROWS];
+    for (int c = 0; c < chunks; c++) {
+        int rows = publisher_chunk_rows(count, c);
+        bool same_rows = c < previous_chunks && publisher_chunk_rows(previous->count, c) == rows;
+        
+        if (stamps_valid && same_rows && inv->chunk_stamps[c] < publisher->published_version) {
+            version->chunks[c] = previous->chunks[c];
+            version->chunks[c]->refs++;
+        } else {
+            version->chunks[c] = publisher_copy_chunk(inv, c, rows);
+        }
+        
+        inventory_read_display(inv, c * INVENTORY_CHUNK_ROWS, rows, slots);
+        if (same_rows && memcmp(previous->order[c]->slots, slots, (size_t)rows * sizeof(int)) == 0) {
+            version->order[c] = previous->order[c];
+            version->order[c]->refs++;
+        } else if ((version->order[c] = malloc(sizeof(InventoryOrderChunk))) != NULL) {
+            version->order[c]->refs = 1;
+            memcpy(version->order[c]->slots, slots, (size_t)rows * sizeof(int));
+        }
+        
+        if (!version->chunks[c] || !version->order[c]) {
+            publisher_free_version(version);
+            return NULL;
+        }
+    }
+    return version;
+}
+
+static bool publisher_same_version(const InventoryVersion *a, const InventoryVersion *b) {
+    if (a->version != b->version || a->count != b->count || a->next_id != b->next_id) {
+        return false;
+    }
+    int chunks = publisher_chunk_count(a->count);
+    for (int c = 0; c < chunks; c++) {
+        if (a->chunks[c] != b->chunks[c] || a->order[c] != b->order[c]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Frees the retired versions every reader inside entered after; the write
+// lock must be held
+static int publisher_reclaim_locked(InventoryPublisher *publisher) {
+    uint64_t oldest = UINT64_MAX;
+    for (int r = 0; r < INVENTORY_PUBLISHER_MAX_READERS; r++) {
+        uint64_t epoch = __atomic_load_n(&publisher->readers[r].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    
+    InventoryVersion **link = &publisher->retired;
+    while (*link) {
+        InventoryVersion *version = *link;
+        if (version->retired_epoch < oldest) {
+            *link = version->next_retired;
+            publisher_free_version(version);
+            publisher->retired_count--;
+        } else {
+            link = &version->next_retired;
+        }
+    }
+    return publisher->retired_count;
+}
+
+bool inventory_publisher_publish(InventoryPublisher *publisher, Inventory *inv) {
+    pthread_mutex_lock(&publisher->write_lock);
+    InventoryVersion *previous = publisher->current;  // Only writers change it
+    InventoryVersion *version = publisher_build(publisher, inv, previous);
+    if (!version) {
+        pthread_mutex_unlock(&publisher->write_lock);
+        return false;
+    }
+    
+    publisher->published_version = inv->version;
+    if (previous && publisher_same_version(version, previous)) {
+        publisher_free_version(version);  // Nothing changed; keep the current one
+    } else {
+        // The retired version is tagged with the epoch after the swap: any
+        // reader that still got it entered no later than that
+        __atomic_store_n(&publisher->current, version, __ATOMIC_SEQ_CST);
+        if (previous) {
+            previous->retired_epoch = __atomic_load_n(&publisher->epoch, __ATOMIC_SEQ_CST);
+            previous->next_retired = publisher->retired;
+            publisher->retired = previous;
+            publisher->retired_count++;
+            __atomic_fetch_add(&publisher->epoch, 1, __ATOMIC_SEQ_CST);
+        }
+    }
+    
+    publisher_reclaim_locked(publisher);
+    pthread_mutex_unlock(&publisher->write_lock);
+    return true;
+}
+
+int inventory_publisher_reclaim(InventoryPublisher *publisher) {
+    pthread_mutex_lock(&publisher->write_lock);
+    int held = publisher_reclaim_locked(publisher);
+    pthread_mutex_unlock(&publisher->write_lock);
+    return held;
+}
+
+int inventory_publisher_register(InventoryPublisher *publisher) {
+    for (int r = 0; r < INVENTORY_PUBLISHER_MAX_READERS; r++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&publisher->readers[r].claimed, &expected, 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+void inventory_publisher_unregister(InventoryPublisher *publisher, int reader) {
+    __atomic_store_n(&publisher->readers[reader].epoch, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&publisher->readers[reader].claimed, 0, __ATOMIC_SEQ_CST);
+}
+
+// The epoch is announced before the version is loaded, so a writer that
+// retires the loaded version afterwards sees this reader and keeps it
+const InventoryVersion *inventory_publisher_enter(InventoryPublisher *publisher, int reader) {
+    uint64_t epoch = __atomic_load_n(&publisher->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&publisher->readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&publisher->current, __ATOMIC_SEQ_CST);
+}
+
+void inventory_publisher_exit(InventoryPublisher *publisher, int reader) {
+    __atomic_store_n(&publisher->readers[reader].epoch, 0, __ATOMIC_SEQ_CST);
+}
+
+int inventory_version_slot_at(const InventoryVersion *version, int position) {
+    return version->order[position / INVENTORY_CHUNK_ROWS]->slots[position % INVENTORY_CHUNK_ROWS];
+}
+
+static const char *version_name_at(const InventoryVersion *version, int slot) {
+    const InventoryChunk *chunk = version->chunks[slot / INVENTORY_CHUNK_ROWS];
+    return chunk->names + chunk->name_offsets[slot % INVENTORY_CHUNK_ROWS];
+}
+
+void inventory_version_read_slot(const InventoryVersion *version, int slot, InventoryItem *item) {
+    const InventoryChunk *chunk = version->chunks[slot / INVENTORY_CHUNK_ROWS];
+    int i = slot % INVENTORY_CHUNK_ROWS;
+    item->id = chunk->ids[i];
+    memcpy(item->name, chunk->names + chunk->name_offsets[i], (size_t)chunk->name_lengths[i] + 1);
+    item->quantity = chunk->quantities[i];
+    item->price = chunk->prices[i];
+    item->reorder_level = chunk->reorder_levels[i];
+}
+
+void inventory_version_read(const InventoryVersion *version, int position, InventoryItem *item) {
+    inventory_version_read_slot(version, inventory_version_slot_at(version, position), item);
+}
+
+int inventory_version_search(const InventoryVersion *version, const char *query, int *ids, int max_results) {
+    StringMatcher matcher;
+    string_matcher_init(&matcher, query);
+    
+    int count = 0;
+    for (int position = 0; position < version->count && count < max_results; position++) {
+        int slot = inventory_version_slot_at(version, position);
+        const InventoryChunk *chunk = version->chunks[slot / INVENTORY_CHUNK_ROWS];
+        int i = slot % INVENTORY_CHUNK_ROWS;
+        if (string_matcher_find(&matcher, chunk->names + chunk->name_offsets[i], chunk->name_lengths[i])) {
+            ids[count++] = chunk->ids[i];
+        }
+    }
+    return count;
+}
+
+// A multi-key order over display positions, passed to parallel_sort
+typedef struct {
+    const InventoryVersion *version;
+    const InventorySortKey *keys;
+    int key_count;
+} VersionKeyOrder;
+
+static int version_compare_key(const InventoryVersion *version, SortCriteria criteria, int a, int b) {
+    const InventoryChunk *chunk_a = version->chunks[a / INVENTORY_CHUNK_ROWS];
+    const InventoryChunk *chunk_b = version->chunks[b / INVENTORY_CHUNK_ROWS];
+    int i = a % INVENTORY_CHUNK_ROWS;
+    int j = b % INVENTORY_CHUNK_ROWS;
+    switch (criteria) {
+        case SORT_BY_NAME:
+            return strcasecmp(version_name_at(version, a), version_name_at(version, b));
+        case SORT_BY_QUANTITY: {
+            int x = chunk_a->quantities[i];
+            int y = chunk_b->quantities[j];
+            return (x > y) - (x < y);
+        }
+        case SORT_BY_PRICE: {
+            float x = chunk_a->prices[i];
+            float y = chunk_b->prices[j];
+            return (x > y) - (x < y);
+        }
+        default: {
+            int x = chunk_a->ids[i];
+            int y = chunk_b->ids[j];
+            return (x > y) - (x < y);
+        }
+    }
+}
+
+static int version_compare_keys(const void *context, int a, int b) {
+    const VersionKeyOrder *order = context;
+    int slot_a = inventory_version_slot_at(order->version, a);
+    int slot_b = inventory_version_slot_at(order->version, b);
+    for (int k = 0; k < order->key_count; k++) {
+        int result = version_compare_key(order->version, order->keys[k].criteria, slot_a, slot_b);
+        if (result != 0) {
+            return order->keys[k].ascending ? result : -result;
+        }
+    }
+    return 0;
+}
+
+bool inventory_version_sort(const InventoryVersion *version, const InventorySortKey *keys, int key_count,
+                            int *positions) {
+    if (key_count < 1 || key_count > INVENTORY_MAX_SORT_KEYS) {
+        return false;
+    }
+    for (int i = 0; i < version->count; i++) {
+        positions[i] = i;
+    }
+    
+    // Stable, so equal keys keep the display order
+    VersionKeyOrder order = {version, keys, key_count};
+    return parallel_sort(positions, version->count, version_compare_keys, &order);
+}
@@ -0,0 +1,531 @@
+#define _POSIX_C_SOURCE 200809L  // For pthreads
+#include "journal.h"
+#include "csv_io.h"
+#include "snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JOURNAL_BYTE_ORDER 0x01020304u
+#define JOURNAL_RECORD_HEADER_SIZE 8  // checksum, type, length
+#define JOURNAL_MAX_RECORD_SIZE 128
+#define JOURNAL_INITIAL_BUFFER_SIZE 4096
+
+static uint32_t journal_checksum(const unsigned char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void journal_header_init(JournalHeader *header, const FileStamp *base) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, JOURNAL_MAGIC, sizeof(header->magic));
+    header->version = JOURNAL_VERSION;
+    header->byte_order = JOURNAL_BYTE_ORDER;
+    header->base = *base;
+}
+
+// Encodes a record into out (JOURNAL_MAX_RECORD_SIZE bytes) and returns its size
+static size_t journal_encode(unsigned char *out, uint16_t type, const void *body, size_t body_size,
+                             const char *name, size_t name_length) {
+    uint16_t length = (uint16_t)(body_size + name_length);
+    memcpy(out + 4, &type, sizeof(type));
+    memcpy(out + 6, &length, sizeof(length));
+    memcpy(out + JOURNAL_RECORD_HEADER_SIZE, body, body_size);
+    if (name_length > 0) {
+        memcpy(out + JOURNAL_RECORD_HEADER_SIZE + body_size, name, name_length);
+    }
+    
+    uint32_t checksum = journal_checksum(out + 4, 4 + (size_t)length);
+    memcpy(out, &checksum, sizeof(checksum));
+    return JOURNAL_RECORD_HEADER_SIZE + length;
+}
+
+// Returns the size of the intact record at data, or 0 if it is torn,
+// corrupt or unknown (which ends replay)
+static size_t journal_decode(const unsigned char *data, size_t available, uint16_t *type,
+                             const unsigned char **body, size_t *body_size) {
+    if (available < JOURNAL_RECORD_HEADER_SIZE) {
+        return 0;
+    }
+    
+    uint32_t checksum;
+    uint16_t length;
+    memcpy(&checksum, data, sizeof(checksum));
+    memcpy(type, data + 4, sizeof(*type));
+    memcpy(&length, data + 6, sizeof(length));
+    if ((size_t)length > available - JOURNAL_RECORD_HEADER_SIZE ||
+        journal_checksum(data + 4, 4 + (size_t)length) != checksum) {
+        return 0;
+    }
+    
+    switch (*type) {
+        case JOURNAL_ADD:
+        case JOURNAL_UPDATE:
+        case JOURNAL_DELETE:
+            if (length < sizeof(JournalItemBody) || length - sizeof(JournalItemBody) > MAX_NAME_LENGTH - 1) {
+                return 0;
+            }
+            break;
+        case JOURNAL_REORDER_LEVEL:
+            if (length != sizeof(JournalReorderBody)) {
+                return 0;
+            }
+            break;
+        case JOURNAL_CHECKPOINT:
+            if (length != sizeof(JournalCheckpointBody)) {
+                return 0;
+            }
+            break;
+        default:
+            return 0;
+    }
+    
+    *body = data + JOURNAL_RECORD_HEADER_SIZE;
+    *body_size = length;
+    return JOURNAL_RECORD_HEADER_SIZE + length;
+}
+
+// Applies an item record as an upsert or delete, so records the base
+// already contains are harmless
+static void journal_apply(Inventory *inv, uint16_t type, const unsigned char *body, size_t body_size) {
+    if (type == JOURNAL_REORDER_LEVEL) {
+        JournalReorderBody reorder;
+        memcpy(&reorder, body, sizeof(reorder));
+        inventory_set_reorder_level(inv, reorder.id, reorder.reorder_level);
+        return;
+    }
+    
+    JournalItemBody item;
+    memcpy(&item, body, sizeof(item));
+    
+    if (type == JOURNAL_DELETE) {
+        inventory_delete_item(inv, item.id);
+    } else {
+        char name[MAX_NAME_LENGTH];
+        size_t name_length = body_size - sizeof(item);
+        memcpy(name, body + sizeof(item), name_length);
+        name[name_length] = '\0';
+        
+        if (inventory_get_index_by_id(inv, item.id) == -1) {
+            inventory_insert_item(inv, item.id, name, item.quantity, item.price);
+        } else {
+            inventory_update_item(inv, item.id, name, item.quantity, item.price);
+        }
+    }
+    
+    if (item.next_id > inv->next_id) {
+        inv->next_id = item.next_id;
+    }
+}
+
+// Replays the records of an existing journal that apply to the CSV stamped
+// csv_stamp and returns them (checkpoint markers dropped) in *kept for the
+// rewritten file. Returns false only when out of memory.
+static bool journal_replay(const MappedFile *file, const FileStamp *csv_stamp, Inventory *inv,
+                           unsigned char **kept, size_t *kept_size) {
+    *kept = NULL;
+    *kept_size = 0;
+    
+    JournalHeader header;
+    if (file->size < sizeof(header)) {
+        return true;
+    }
+    memcpy(&header, file->data, sizeof(header));
+    if (memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != JOURNAL_VERSION || header.byte_order != JOURNAL_BYTE_ORDER) {
+        return true;
+    }
+    
+    // Find where the intact records end and where those the current CSV
+    // lacks begin: at the start if the journal was written against it,
+    // otherwise at the last checkpoint that produced it
+    const unsigned char *records = (const unsigned char *)file->data + sizeof(header);
+    size_t available = file->size - sizeof(header);
+    bool applies = file_stamp_equal(&header.base, csv_stamp);
+    size_t start = 0;
+    size_t end = 0;
+    for (;;) {
+        uint16_t type;
+        const unsigned char *body;
+        size_t body_size;
+        size_t record_size = journal_decode(records + end, available - end, &type, &body, &body_size);
+        if (record_size == 0) {
+            break;
+        }
+        
+        if (type == JOURNAL_CHECKPOINT) {
+            JournalCheckpointBody marker;
+            memcpy(&marker, body, sizeof(marker));
+            if (file_stamp_equal(&marker.base, csv_stamp) && marker.position <= end) {
+                applies = true;
+                start = (size_t)marker.position;
+            }
+        }
+        end += record_size;
+    }
+    if (!applies || start == end) {
+        return true;
+    }
+    
+    *kept = malloc(end - start);
+    if (!*kept) {
+        return false;
+    }
+    
+    size_t offset = start;
+    while (offset < end) {
+        uint16_t type;
+        const unsigned char *body;
+        size_t body_size;
+        size_t record_size = journal_decode(records + offset, end - offset, &type, &body, &body_size);
+        if (record_size == 0) {
+            break;  // start was not on a record boundary
+        }
+        
+        if (type != JOURNAL_CHECKPOINT) {
+            journal_apply(inv, type, body, body_size);
+            memcpy(*kept + *kept_size, records + offset, record_size);
+            *kept_size += record_size;
+        }
+        offset += record_size;
+    }
+    return true;
+}
+
+// Atomically replaces the journal file with a header for base plus records
+static bool journal_write_file(const char *filename, const FileStamp *base, const void *records, size_t size) {
+    JournalHeader header;
+    journal_header_init(&header, base);
+    
+    AtomicFile output;
+    if (!atomic_file_open(&output, filename)) {
+        return false;
+    }
+    if (fwrite(&header, sizeof(header), 1, output.file) != 1 ||
+        (size > 0 && fwrite(records, 1, size, output.file) != size)) {
+        atomic_file_abort(&output);
+        return false;
+    }
+    return atomic_file_commit(&output);
+}
+
+// Group commit: takes everything appended so far, writes it with a single
+// fsync and lets appends made in the meantime form the next batch
+static void *journal_sync_main(void *arg) {
+    Journal *journal = arg;
+    char *spare = NULL;
+    size_t spare_capacity = 0;
+    
+    pthread_mutex_lock(&journal->lock);
+    for (;;) {
+        while (!journal->stopping && journal->pending_used == 0) {
+            pthread_cond_wait(&journal->wake, &journal->lock);
+        }
+        if (journal->pending_used == 0) {
+            break;  // Stopping with nothing left to write
+        }
+        
+        char *batch = journal->pending;
+        size_t batch_size = journal->pending_used;
+        size_t batch_capacity = journal->pending_capacity;
+        journal->pending = spare;
+        journal->pending_capacity = spare_capacity;
+        journal->pending_used = 0;
+        journal->writing = true;
+        FILE *file = journal->file;
+        pthread_mutex_unlock(&journal->lock);
+        
+        bool ok = fwrite(batch, 1, batch_size, file) == batch_size && file_sync(file);
+        
+        pthread_mutex_lock(&journal->lock);
+        journal->writing = false;
+        if (ok) {
+            journal->committed += batch_size;
+        } else {
+            journal->failed = true;
+        }
+        spare = batch;
+        spare_capacity = batch_capacity;
+        pthread_cond_broadcast(&journal->synced);
+    }
+    pthread_mutex_unlock(&journal->lock);
+    
+    free(spare);
+    return NULL;
+}
+
+static void journal_append(Journal *journal, const unsigned char *record, size_t record_size) {
+    pthread_mutex_lock(&journal->lock);
+    if (!journal->failed && journal->pending_used + record_size > journal->pending_capacity) {
+        size_t new_capacity = journal->pending_capacity > 0 ? journal->pending_capacity * 2 : JOURNAL_INITIAL_BUFFER_SIZE;
+        char *pending = realloc(journal->pending, new_capacity);
+        if (pending) {
+            journal->pending = pending;
+            journal->pending_capacity = new_capacity;
+        } else {
+            journal->failed = true;
+        }
+    }
+    
+    if (!journal->failed) {
+        memcpy(journal->pending + journal->pending_used, record, record_size);
+        journal->pending_used += record_size;
+        journal->appended += record_size;
+        pthread_cond_signal(&journal->wake);
+    }
+    pthread_mutex_unlock(&journal->lock);
+}
+
+bool journal_open(Journal *journal, const char *filename, const char *csv_filename,
+                  const char *snapshot_filename, Inventory *inv) {
+    // A missing CSV is stamped all zero, so journals started without one still apply
+    FileStamp csv_stamp = {0, 0, 0};
+    file_stamp_get(csv_filename, &csv_stamp);
+    
+    unsigned char *kept = NULL;
+    size_t kept_size = 0;
+    MappedFile existing;
+    if (mapped_file_open(&existing, filename)) {
+        bool ok = journal_replay(&existing, &csv_stamp, inv, &kept, &kept_size);
+        mapped_file_close(&existing);
+        if (!ok) {
+            return false;
+        }
+    }
+    
+    // Rewrite the file against the current CSV, which also drops a torn tail
+    bool ok = journal_write_file(filename, &csv_stamp, kept, kept_size);
+    free(kept);
+    FILE *file = ok ? fopen(filename, "a+b") : NULL;
+    if (!file) {
+        return false;
+    }
+    
+    journal->filename = filename;
+    journal->csv_filename = csv_filename;
+    journal->snapshot_filename = snapshot_filename;
+    journal->file = file;
+    journal->pending = NULL;
+    journal->pending_used = 0;
+    journal->pending_capacity = 0;
+    journal->appended = kept_size;
+    journal->committed = kept_size;
+    journal->dropped = 0;
+    journal->writing = false;
+    journal->failed = false;
+    journal->stopping = false;
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_cond_init(&journal->wake, NULL);
+    pthread_cond_init(&journal->synced, NULL);
+    
+    if (pthread_create(&journal->sync_thread, NULL, journal_sync_main, journal) != 0) {
+        pthread_mutex_destroy(&journal->lock);
+        pthread_cond_destroy(&journal->wake);
+        pthread_cond_destroy(&journal->synced);
+        fclose(file);
+        return false;
+    }
+    return true;
+}
+
+void journal_close(Journal *journal) {
+    pthread_mutex_lock(&journal->lock);
+    journal->stopping = true;
+    pthread_cond_signal(&journal->wake);
+    pthread_mutex_unlock(&journal->lock);
+    pthread_join(journal->sync_thread, NULL);
+    
+    fclose(journal->file);
+    free(journal->pending);
+    pthread_mutex_destroy(&journal->lock);
+    pthread_cond_destroy(&journal->wake);
+    pthread_cond_destroy(&journal->synced);
+}
+
+void journal_record(Journal *journal, JournalRecordType type, const Inventory *inv, int id) {
+    unsigned char record[JOURNAL_MAX_RECORD_SIZE];
+    if (type == JOURNAL_REORDER_LEVEL) {
+        int slot = id_index_get(&inv->id_index, id);
+        if (slot == -1) {
+            return;
+        }
+        JournalReorderBody reorder = {id, inv->reorder_levels[slot]};
+        journal_append(journal, record, journal_encode(record, (uint16_t)type, &reorder, sizeof(reorder), NULL, 0));
+        return;
+    }
+    
+    JournalItemBody body = {id, 0, 0.0f, inv->next_id};
+    const char *name = NULL;
+    size_t name_length = 0;
+    
+    if (type != JOURNAL_DELETE) {
+        int slot = id_index_get(&inv->id_index, id);
+        if (slot == -1) {
+            return;
+        }
+        body.quantity = inv->quantities[slot];
+        body.price = inv->prices[slot];
+        name = inventory_name_at(inv, slot);
+        name_length = inv->name_lengths[slot];
+    }
+    
+    journal_append(journal, record, journal_encode(record, (uint16_t)type, &body, sizeof(body), name, name_length));
+}
+
+bool journal_sync(Journal *journal) {
+    pthread_mutex_lock(&journal->lock);
+    uint64_t target = journal->appended;
+    while (!journal->failed && journal->committed < target) {
+        pthread_cond_wait(&journal->synced, &journal->lock);
+    }
+    bool ok = !journal->failed;
+    pthread_mutex_unlock(&journal->lock);
+    return ok;
+}
+
+bool journal_needs_checkpoint(Journal *journal) {
+    pthread_mutex_lock(&journal->lock);
+    bool needed = journal->appended - journal->dropped >= JOURNAL_CHECKPOINT_SIZE;
+    pthread_mutex_unlock(&journal->lock);
+    return needed;
+}
+
+// Squeezes checkpoint markers out of a run of records; returns the new size
+static size_t journal_drop_markers(unsigned char *records, size_t size) {
+    size_t kept = 0;
+    size_t offset = 0;
+    while (offset < size) {
+        uint16_t type;
+        const unsigned char *body;
+        size_t body_size;
+        size_t record_size = journal_decode(records + offset, size - offset, &type, &body, &body_size);
+        if (record_size == 0) {
+            break;
+        }
+        if (type != JOURNAL_CHECKPOINT) {
+            memmove(records + kept, records + offset, record_size);
+            kept += record_size;
+        }
+        offset += record_size;
+    }
+    return kept;
+}
+
+// Rewrites the journal against the new CSV, keeping only the records
+// appended after position. Records still pending are written to the new
+// file by the sync thread as usual.
+static bool journal_compact(Journal *journal, const FileStamp *base, uint64_t position) {
+    pthread_mutex_lock(&journal->lock);
+    while (journal->writing) {
+        pthread_cond_wait(&journal->synced, &journal->lock);
+    }
+    
+    // After a write error records past committed were never written, so the
+    // journal can only be reset if the checkpoint covers all of them
+    if (journal->failed && position != journal->appended) {
+        pthread_mutex_unlock(&journal->lock);
+        return false;
+    }
+    
+    size_t tail_size = 0;
+    if (!journal->failed) {
+        tail_size = (size_t)(journal->committed - position);
+    }
+    char *tail = malloc(tail_size > 0 ? tail_size : 1);
+    bool ok = tail != NULL;
+    if (ok && tail_size > 0) {
+        long offset = (long)(sizeof(JournalHeader) + (position - journal->dropped));
+        ok = fseek(journal->file, offset, SEEK_SET) == 0 &&
+             fread(tail, 1, tail_size, journal->file) == tail_size;
+        fseek(journal->file, 0, SEEK_END);  // Required before the next write
+    }
+    // Markers are dropped too; they all precede any later checkpoint's
+    // position, so counting them as dropped keeps file offsets right
+    size_t kept_size = ok ? journal_drop_markers((unsigned char *)tail, tail_size) : 0;
+    
+    ok = ok && journal_write_file(journal->filename, base, tail, kept_size);
+    FILE *file = ok ? fopen(journal->filename, "a+b") : NULL;
+    if (file) {
+        fclose(journal->file);
+        journal->file = file;
+        journal->dropped = position + (tail_size - kept_size);
+        if (journal->failed) {
+            journal->failed = false;
+            journal->pending_used = 0;
+            journal->committed = journal->appended;
+        }
+    } else if (ok) {
+        journal->failed = true;  // The old handle now points at a replaced file
+    }
+    pthread_mutex_unlock(&journal->lock);
+    
+    free(tail);
+    return file != NULL;
+}
+
+uint64_t journal_position(Journal *journal) {
+    pthread_mutex_lock(&journal->lock);
+    uint64_t position = journal->appended;
+    pthread_mutex_unlock(&journal->lock);
+    return position;
+}
+
+// Replaces the CSV with output once a checkpoint marker for position is on disk
+static bool journal_checkpoint_replace(Journal *journal, AtomicFile *output, uint64_t position) {
+    // The marker has to be on disk before the new CSV replaces the old one
+    JournalCheckpointBody marker;
+    bool marked = file_stamp_get(output->temp_filename, &marker.base);
+    if (marked) {
+        pthread_mutex_lock(&journal->lock);
+        marker.position = position - journal->dropped;
+        pthread_mutex_unlock(&journal->lock);
+        
+        unsigned char record[JOURNAL_MAX_RECORD_SIZE];
+        journal_append(journal, record, journal_encode(record, JOURNAL_CHECKPOINT, &marker, sizeof(marker), NULL, 0));
+        marked = journal_sync(journal);
+    }
+    
+    // A failed journal holds nothing worth protecting, so the save goes ahead
+    pthread_mutex_lock(&journal->lock);
+    bool failed = journal->failed;
+    pthread_mutex_unlock(&journal->lock);
+    if (!marked && !failed) {
+        atomic_file_abort(output);
+        return false;
+    }
+    return atomic_file_replace(output);
+}
+
+// If compaction fails the marker still tells recovery where to start
+static void journal_checkpoint_compact(Journal *journal, uint64_t position) {
+    FileStamp base;
+    if (file_stamp_get(journal->csv_filename, &base)) {
+        journal_compact(journal, &base, position);
+    }
+}
+
+bool journal_checkpoint(Journal *journal, const Inventory *inv, uint64_t position) {
+    AtomicFile output;
+    if (!save_inventory_to_temp_file(inv, journal->csv_filename, &output) ||
+        !journal_checkpoint_replace(journal, &output, position)) {
+        return false;
+    }
+    
+    snapshot_save(inv, journal->snapshot_filename, journal->csv_filename);
+    journal_checkpoint_compact(journal, position);
+    return true;
+}
+
+bool journal_checkpoint_version(Journal *journal, const InventoryVersion *version, uint64_t position) {
+    AtomicFile output;
+    if (!save_inventory_version_to_temp_file(version, journal->csv_filename, &output) ||
+        !journal_checkpoint_replace(journal, &output, position)) {
+        return false;
+    }
+    
+    snapshot_save_version(version, journal->snapshot_filename, journal->csv_filename);
+    journal_checkpoint_compact(journal, position);
+    return true;
+}
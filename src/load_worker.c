@@ -0,0 +1,50 @@
+#define _POSIX_C_SOURCE 200809L  // For pthreads
+#include "load_worker.h"
+#include "snapshot.h"
+
+static void *load_worker_main(void *arg) {
+    LoadWorker *worker = arg;
+    
+    worker->loaded = load_inventory_with_snapshot(worker->inv, worker->csv_filename, worker->snapshot_filename);
+    
+    // Replay edits made since the last save
+    worker->journal_opened = journal_open(worker->journal, worker->journal_filename, worker->csv_filename,
+                                          worker->snapshot_filename, worker->inv);
+    
+    // Best effort; if it fails the first save publishes everything instead
+    if (worker->publisher) {
+        inventory_publisher_publish(worker->publisher, worker->inv);
+    }
+    
+    if (worker->callback) {
+        worker->callback(worker->loaded, worker->user_data);
+    }
+    return NULL;
+}
+
+void load_worker_start(LoadWorker *worker, Inventory *inv, InventoryPublisher *publisher, Journal *journal,
+                       const char *csv_filename, const char *snapshot_filename, const char *journal_filename,
+                       LoadWorkerCallback callback, void *user_data) {
+    worker->inv = inv;
+    worker->publisher = publisher;
+    worker->journal = journal;
+    worker->csv_filename = csv_filename;
+    worker->snapshot_filename = snapshot_filename;
+    worker->journal_filename = journal_filename;
+    worker->callback = callback;
+    worker->user_data = user_data;
+    worker->loaded = false;
+    worker->journal_opened = false;
+    
+    worker->threaded = pthread_create(&worker->thread, NULL, load_worker_main, worker) == 0;
+    if (!worker->threaded) {
+        load_worker_main(worker);
+    }
+}
+
+void load_worker_join(LoadWorker *worker) {
+    if (worker->threaded) {
+        pthread_join(worker->thread, NULL);
+        worker->threaded = false;
+    }
+}
@@ -1,8 +1,14 @@
 #include <gtk/gtk.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "inventory.h"
 #include "gui.h"
 #include "utils.h"
+#include "snapshot.h"
+#include "save_worker.h"
+#include "load_worker.h"
+#include "search_worker.h"
+#include "inventory_publisher.h"
 
 static void on_window_destroy(GtkWidget *widget, gpointer data) {
     (void)widget;
@@ -408,6 +414,11 @@ int main(int argc, char *argv[]) {
     app_data.inventory = &inventory;
     app_data.selected_id = -1;
     
+    // Exports and saves read published versions of the inventory, never the live one
+    InventoryPublisher publisher;
+    inventory_publisher_init(&publisher);
+    app_data.publisher = &publisher;
+    
     // Apply enhanced CSS styling
     setup_enhanced_css();
     
@@ -415,17 +426,66 @@ int main(int argc, char *argv[]) {
     app_data.window = create_main_window(&app_data);
     g_signal_connect(app_data.window, "destroy", G_CALLBACK(on_window_destroy), NULL);
     
-    // Try to load existing inventory
-    if (load_inventory_from_file(&inventory, "inventory.csv")) {
-        refresh_tree_view(&app_data);
-        update_status(&app_data, "📂 Inventory loaded successfully! Ready to manage your stock.");
-    } else {
-        update_status(&app_data, "🚀 StockFlow Ready - Welcome to your professional inventory system!");
+    // Saves run on a worker thread, on request or when the timer finds
+    // unsaved changes; the journal is handed over once loading is done
+    SaveWorker save_worker;
+    if (save_worker_start(&save_worker, &publisher, NULL, "inventory.csv", "inventory.snapshot",
+                          on_save_finished, &app_data)) {
+        app_data.save_worker = &save_worker;
+        g_timeout_add_seconds(AUTOSAVE_INTERVAL_SECONDS, on_autosave_timeout, &app_data);
+    }
+    
+    // Searches run on their own thread so typing never waits for a scan
+    SearchWorker search_worker;
+    if (search_worker_start(&search_worker, &inventory, on_search_finished, &app_data)) {
+        app_data.search_worker = &search_worker;
     }
     
-    // Show the application
+    // Latency histograms go to this file every minute and at exit
+    app_data.metrics_filename = getenv("STOCKFLOW_METRICS_FILE");
+    if (app_data.metrics_filename) {
+        g_timeout_add_seconds(METRICS_DUMP_INTERVAL_SECONDS, on_metrics_dump_timeout, &app_data);
+    }
+    
+    // Load the inventory (snapshot or CSV, then journal replay) in the
+    // background; the window shows right away and the table appears in one
+    // go once the load finishes
+    set_loading(&app_data, true);
+    update_status(&app_data, "⏳ StockFlow: Loading inventory...");
     gtk_widget_show_all(app_data.window);
+    
+    Journal journal;
+    LoadWorker load_worker;
+    app_data.load_worker = &load_worker;
+    load_worker_start(&load_worker, &inventory, &publisher, &journal, "inventory.csv", "inventory.snapshot",
+                      "inventory.journal", on_load_finished, &app_data);
+    
     gtk_main();
     
+    // Closed mid-load: let the loader finish before tearing down
+    if (app_data.load_worker) {
+        load_worker_join(app_data.load_worker);
+        if (app_data.load_worker->journal_opened) {
+            app_data.journal = app_data.load_worker->journal;
+        }
+    }
+    if (app_data.exporting) {
+        export_worker_join(&app_data.export_worker);
+    }
+    if (app_data.search_worker) {
+        search_worker_stop(app_data.search_worker);
+    }
+    if (app_data.save_worker) {
+        save_worker_stop(app_data.save_worker);
+    }
+    if (app_data.journal) {
+        journal_close(app_data.journal);
+    }
+    if (app_data.metrics_filename) {
+        on_metrics_dump_timeout(&app_data);
+    }
+    g_object_unref(app_data.model);
+    inventory_publisher_free(&publisher);
+    inventory_free(&inventory);
     return 0;
 }
\ No newline at end of file
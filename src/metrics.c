@@ -0,0 +1,185 @@
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime
+#include "metrics.h"
+#include "file_util.h"
+#include <string.h>
+#include <time.h>
+
+// Counters are bumped with relaxed atomic adds, so recording never takes a
+// lock and threads only contend on the cache lines of the same operation
+static MetricHistogram metrics[METRIC_OP_COUNT];
+
+static const char *const metrics_op_names[METRIC_OP_COUNT] = {
+    "add", "update", "delete", "find", "sort", "search", "load", "save"
+};
+
+uint64_t metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Small values map to themselves; larger ones to their power of two plus
+// the next METRICS_SUB_BUCKET_BITS bits below the leading one
+static int metrics_bucket_index(uint64_t ns) {
+    if (ns < METRICS_SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    if (exponent > METRICS_MAX_EXPONENT) {
+        return METRICS_BUCKET_COUNT - 1;
+    }
+    int sub_bucket = (int)(ns >> (exponent - METRICS_SUB_BUCKET_BITS)) & (METRICS_SUB_BUCKETS - 1);
+    return (exponent - METRICS_SUB_BUCKET_BITS + 1) * METRICS_SUB_BUCKETS + sub_bucket;
+}
+
+// Smallest value in the bucket
+static uint64_t metrics_bucket_lower(int index) {
+    if (index < METRICS_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int exponent = index / METRICS_SUB_BUCKETS + METRICS_SUB_BUCKET_BITS - 1;
+    uint64_t sub_bucket = (uint64_t)(index % METRICS_SUB_BUCKETS);
+    return (METRICS_SUB_BUCKETS + sub_bucket) << (exponent - METRICS_SUB_BUCKET_BITS);
+}
+
+static uint64_t metrics_bucket_upper(int index) {
+    return index + 1 < METRICS_BUCKET_COUNT ? metrics_bucket_lower(index + 1) - 1 : UINT64_MAX;
+}
+
+void metrics_record(MetricOp op, uint64_t start, uint64_t bytes) {
+    uint64_t ns = metrics_now() - start;
+    MetricHistogram *histogram = &metrics[op];
+    
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->bytes, bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->buckets[metrics_bucket_index(ns)], 1, __ATOMIC_RELAXED);
+    
+    uint64_t max = __atomic_load_n(&histogram->max_ns, __ATOMIC_RELAXED);
+    while (ns > max && !__atomic_compare_exchange_n(&histogram->max_ns, &max, ns, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+bool metrics_enabled(void) {
+#ifdef STOCKFLOW_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char *metrics_op_name(MetricOp op) {
+    return (op >= 0 && op < METRIC_OP_COUNT) ? metrics_op_names[op] : "unknown";
+}
+
+void metrics_get(MetricOp op, MetricHistogram *histogram) {
+    const MetricHistogram *source = &metrics[op];
+    histogram->count = __atomic_load_n(&source->count, __ATOMIC_RELAXED);
+    histogram->total_ns = __atomic_load_n(&source->total_ns, __ATOMIC_RELAXED);
+    histogram->max_ns = __atomic_load_n(&source->max_ns, __ATOMIC_RELAXED);
+    histogram->bytes = __atomic_load_n(&source->bytes, __ATOMIC_RELAXED);
+    for (int i = 0; i < METRICS_BUCKET_COUNT; i++) {
+        histogram->buckets[i] = __atomic_load_n(&source->buckets[i], __ATOMIC_RELAXED);
+    }
+}
+
+void metrics_reset(void) {
+    for (int op = 0; op < METRIC_OP_COUNT; op++) {
+        MetricHistogram *histogram = &metrics[op];
+        __atomic_store_n(&histogram->count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&histogram->total_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&histogram->max_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&histogram->bytes, 0, __ATOMIC_RELAXED);
+        for (int i = 0; i < METRICS_BUCKET_COUNT; i++) {
+            __atomic_store_n(&histogram->buckets[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+uint64_t metrics_percentile(const MetricHistogram *histogram, double p) {
+    // Sum the buckets rather than trusting count, which may be a little ahead
+    uint64_t total = 0;
+    for (int i = 0; i < METRICS_BUCKET_COUNT; i++) {
+        total += histogram->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    
+    uint64_t rank = (uint64_t)(p * (double)total + 0.5);
+    rank = rank < 1 ? 1 : (rank > total ? total : rank);
+    uint64_t seen = 0;
+    for (int i = 0; i < METRICS_BUCKET_COUNT; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint64_t upper = metrics_bucket_upper(i);
+            return upper < histogram->max_ns ? upper : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+void metrics_dump_text(FILE *out) {
+    fprintf(out, "%-8s %12s %12s %12s %12s %12s %14s\n",
+            "op", "count", "mean_us", "p50_us", "p99_us", "max_us", "bytes");
+    
+    MetricHistogram histogram;
+    for (int op = 0; op < METRIC_OP_COUNT; op++) {
+        metrics_get((MetricOp)op, &histogram);
+        double mean = histogram.count > 0 ? (double)histogram.total_ns / (double)histogram.count : 0.0;
+        fprintf(out, "%-8s %12llu %12.1f %12.1f %12.1f %12.1f %14llu\n",
+                metrics_op_names[op], (unsigned long long)histogram.count, mean / 1e3,
+                metrics_percentile(&histogram, 0.50) / 1e3, metrics_percentile(&histogram, 0.99) / 1e3,
+                histogram.max_ns / 1e3, (unsigned long long)histogram.bytes);
+    }
+}
+
+void metrics_dump_json(FILE *out) {
+    fprintf(out, "{\"enabled\":%s,\"bucket_bits\":%d,\"ops\":{", metrics_enabled() ? "true" : "false",
+            METRICS_SUB_BUCKET_BITS);
+    
+    MetricHistogram histogram;
+    for (int op = 0; op < METRIC_OP_COUNT; op++) {
+        metrics_get((MetricOp)op, &histogram);
+        fprintf(out, "%s\n\"%s\":{\"count\":%llu,\"total_ns\":%llu,\"max_ns\":%llu,\"bytes\":%llu,"
+                "\"p50_ns\":%llu,\"p99_ns\":%llu,\"buckets\":[",
+                op > 0 ? "," : "", metrics_op_names[op], (unsigned long long)histogram.count,
+                (unsigned long long)histogram.total_ns, (unsigned long long)histogram.max_ns,
+                (unsigned long long)histogram.bytes,
+                (unsigned long long)metrics_percentile(&histogram, 0.50),
+                (unsigned long long)metrics_percentile(&histogram, 0.99));
+        
+        // Only non-empty buckets, as [lower_ns, count] pairs
+        bool first = true;
+        for (int i = 0; i < METRICS_BUCKET_COUNT; i++) {
+            if (histogram.buckets[i] > 0) {
+                fprintf(out, "%s[%llu,%llu]", first ? "" : ",", (unsigned long long)metrics_bucket_lower(i),
+                        (unsigned long long)histogram.buckets[i]);
+                first = false;
+            }
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n}}\n");
+}
+
+bool metrics_write_file(const char *filename) {
+    size_t length = strlen(filename);
+    bool json = length >= 5 && strcmp(filename + length - 5, ".json") == 0;
+    
+    AtomicFile output;
+    if (!atomic_file_open(&output, filename)) {
+        return false;
+    }
+    if (json) {
+        metrics_dump_json(output.file);
+    } else {
+        metrics_dump_text(output.file);
+    }
+    if (ferror(output.file)) {
+        atomic_file_abort(&output);
+        return false;
+    }
+    return atomic_file_commit(&output);
+}
@@ -0,0 +1,103 @@
+#include "name_heap.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NAME_HEAP_INITIAL_CAPACITY 4096
+
+void name_heap_init(NameHeap *heap) {
+    heap->data = NULL;
+    heap->used = 0;
+    heap->capacity = 0;
+    heap->garbage = 0;
+}
+
+void name_heap_free(NameHeap *heap) {
+    free(heap->data);
+    name_heap_init(heap);
+}
+
+void name_heap_clear(NameHeap *heap) {
+    heap->used = 0;
+    heap->garbage = 0;
+}
+
+bool name_heap_reserve(NameHeap *heap, size_t min_capacity) {
+    if (min_capacity <= heap->capacity) {
+        return true;
+    }
+    if (min_capacity > UINT32_MAX) {
+        return false;  // Offsets are 32-bit
+    }
+    
+    size_t new_capacity = (heap->capacity > 0) ? heap->capacity : NAME_HEAP_INITIAL_CAPACITY;
+    while (new_capacity < min_capacity) {
+        new_capacity *= 2;
+    }
+    if (new_capacity > UINT32_MAX) {
+        new_capacity = UINT32_MAX;
+    }
+    
+    char *data = realloc(heap->data, new_capacity);
+    if (!data) {
+        return false;
+    }
+    
+    heap->data = data;
+    heap->capacity = new_capacity;
+    return true;
+}
+
+bool name_heap_assign(NameHeap *heap, const char *data, size_t size, size_t garbage) {
+    if (!name_heap_reserve(heap, size)) {
+        return false;
+    }
+    
+    if (size > 0) {
+        memcpy(heap->data, data, size);
+    }
+    heap->used = size;
+    heap->garbage = garbage;
+    return true;
+}
+
+bool name_heap_append(NameHeap *heap, const char *name, size_t length, uint32_t *offset) {
+    if (!name_heap_reserve(heap, heap->used + length + 1)) {
+        return false;
+    }
+    
+    memcpy(heap->data + heap->used, name, length);
+    heap->data[heap->used + length] = '\0';
+    *offset = (uint32_t)heap->used;
+    heap->used += length + 1;
+    return true;
+}
+
+void name_heap_release(NameHeap *heap, size_t length) {
+    heap->garbage += length + 1;
+}
+
+bool name_heap_needs_compaction(const NameHeap *heap) {
+    return heap->garbage >= NAME_HEAP_INITIAL_CAPACITY && heap->garbage * 2 >= heap->used;
+}
+
+bool name_heap_compact(NameHeap *heap, uint32_t *offsets, const uint8_t *lengths, int count) {
+    size_t live = heap->used - heap->garbage;
+    char *data = malloc(live > 0 ? live : 1);
+    if (!data) {
+        return false;
+    }
+    
+    size_t used = 0;
+    for (int i = 0; i < count; i++) {
+        memcpy(data + used, heap->data + offsets[i], (size_t)lengths[i] + 1);
+        offsets[i] = (uint32_t)used;
+        used += (size_t)lengths[i] + 1;
+    }
+    
+    free(heap->data);
+    heap->data = data;
+    heap->capacity = live > 0 ? live : 1;
+    heap->used = used;
+    heap->garbage = 0;
+    return true;
+}
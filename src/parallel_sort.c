@@ -0,0 +1,275 @@
+#define _POSIX_C_SOURCE 200809L  // For sysconf and pthreads
+#include "parallel_sort.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Runs of this many values are insertion sorted before merging starts
+#define PARALLEL_SORT_INSERTION_RUN 16
+
+// Below this many values per thread, extra threads cost more than they save
+#define PARALLEL_SORT_MIN_PER_THREAD 32768
+
+// Stable insertion sort of values[low, high)
+static void parallel_sort_insertion(int *values, int low, int high, ParallelSortCompare compare,
+                                    const void *context) {
+    for (int i = low + 1; i < high; i++) {
+        int value = values[i];
+        int j = i;
+        while (j > low && compare(context, values[j - 1], value) > 0) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+}
+
+// Merges src[a, a_end) and src[b, b_end) into dst from out onwards; on ties
+// the first run wins, which keeps the sort stable
+static void parallel_sort_merge(const int *src, int a, int a_end, int b, int b_end, int *dst, int out,
+                                ParallelSortCompare compare, const void *context) {
+    while (a < a_end && b < b_end) {
+        dst[out++] = (compare(context, src[b], src[a]) < 0) ? src[b++] : src[a++];
+    }
+    while (a < a_end) dst[out++] = src[a++];
+    while (b < b_end) dst[out++] = src[b++];
+}
+
+// Bottom-up merge sort of values[low, high) using buffer[low, high) as
+// scratch; the result ends up in values
+static void parallel_sort_run(int *values, int *buffer, int low, int high, ParallelSortCompare compare,
+                              const void *context) {
+    for (int start = low; start < high; start += PARALLEL_SORT_INSERTION_RUN) {
+        int end = (high - start > PARALLEL_SORT_INSERTION_RUN) ? start + PARALLEL_SORT_INSERTION_RUN : high;
+        parallel_sort_insertion(values, start, end, compare, context);
+    }
+    
+    int *src = values;
+    int *dst = buffer;
+    for (int width = PARALLEL_SORT_INSERTION_RUN; width < high - low; width *= 2) {
+        for (int start = low; start < high; start += 2 * width) {
+            int mid = (high - start > width) ? start + width : high;
+            int end = (high - mid > width) ? mid + width : high;
+            parallel_sort_merge(src, start, mid, mid, end, dst, start, compare, context);
+        }
+        
+        int *temp = src;
+        src = dst;
+        dst = temp;
+    }
+    
+    if (src != values) {
+        memcpy(values + low, src + low, (size_t)(high - low) * sizeof(int));
+    }
+}
+
+// How many of the first k values of the stable merge of a[0, a_length) and
+// b[0, b_length) come from a. Lets each thread start merging in the middle.
+static int parallel_sort_split(const int *a, int a_length, const int *b, int b_length, int k,
+                               ParallelSortCompare compare, const void *context) {
+    int low = (k > b_length) ? k - b_length : 0;
+    int high = (k < a_length) ? k : a_length;
+    
+    while (low < high) {
+        int i = low + (high - low) / 2;
+        int j = k - i;
+        // a[i] sorts no later than b[j - 1], which is among the first k, so a[i] is too
+        if (j > 0 && compare(context, a[i], b[j - 1]) <= 0) {
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+    return low;
+}
+
+// A reusable barrier; pthread_barrier_t is optional in POSIX and missing on macOS
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int waiting;
+    int generation;
+} SortBarrier;
+
+typedef struct {
+    int *values;
+    int *buffer;
+    int n;
+    ParallelSortCompare compare;
+    const void *context;
+    int thread_count;  // Set once every worker has been started
+    bool started;
+    SortBarrier barrier;
+} SortJob;
+
+typedef struct {
+    SortJob *job;
+    int index;
+} SortWorker;
+
+static void sort_barrier_wait(SortJob *job) {
+    SortBarrier *barrier = &job->barrier;
+    pthread_mutex_lock(&barrier->mutex);
+    int generation = barrier->generation;
+    if (++barrier->waiting == job->thread_count) {
+        barrier->waiting = 0;
+        barrier->generation++;
+        pthread_cond_broadcast(&barrier->cond);
+    } else {
+        while (generation == barrier->generation) {
+            pthread_cond_wait(&barrier->cond, &barrier->mutex);
+        }
+    }
+    pthread_mutex_unlock(&barrier->mutex);
+}
+
+// Run r covers [bounds[r], bounds[r + 1]) of the values
+static int sort_job_bound(const SortJob *job, int run, int run_count) {
+    return (int)((long long)job->n * run / run_count);
+}
+
+// One thread's part of every phase. Each thread first sorts its own run;
+// each round then merges neighbouring runs pairwise, and the output of the
+// round is cut into thread_count equal ranges so every thread does the same
+// amount of merging however few pairs are left.
+static void sort_job_work(SortJob *job, int index) {
+    int threads = job->thread_count;
+    ParallelSortCompare compare = job->compare;
+    const void *context = job->context;
+    
+    parallel_sort_run(job->values, job->buffer, sort_job_bound(job, index, threads),
+                      sort_job_bound(job, index + 1, threads), compare, context);
+    sort_barrier_wait(job);
+    
+    int bounds[PARALLEL_SORT_MAX_THREADS + 1];
+    for (int r = 0; r <= threads; r++) {
+        bounds[r] = sort_job_bound(job, r, threads);
+    }
+    
+    const int *src = job->values;
+    int *dst = job->buffer;
+    int out_low = sort_job_bound(job, index, threads);
+    int out_high = sort_job_bound(job, index + 1, threads);
+    for (int run_count = threads; run_count > 1; run_count = (run_count + 1) / 2) {
+        for (int r = 0; r < run_count; r += 2) {
+            int low = bounds[r];
+            int mid = bounds[r + 1];
+            int high = (r + 2 <= run_count) ? bounds[r + 2] : mid;
+            int begin = (out_low > low) ? out_low : low;
+            int end = (out_high < high) ? out_high : high;
+            if (begin >= end) {
+                continue;
+            }
+            
+            // This thread's slice [begin, end) of the merged pair
+            int a_begin = low + parallel_sort_split(src + low, mid - low, src + mid, high - mid, begin - low,
+                                                    compare, context);
+            int a_end = low + parallel_sort_split(src + low, mid - low, src + mid, high - mid, end - low,
+                                                  compare, context);
+            int b_begin = mid + (begin - low) - (a_begin - low);
+            int b_end = mid + (end - low) - (a_end - low);
+            parallel_sort_merge(src, a_begin, a_end, b_begin, b_end, dst, begin, compare, context);
+        }
+        
+        // The merged runs keep every other boundary, plus the end
+        int merged_count = (run_count + 1) / 2;
+        for (int r = 0; r <= merged_count; r++) {
+            bounds[r] = bounds[(2 * r < run_count) ? 2 * r : run_count];
+        }
+        const int *temp = src;
+        src = dst;
+        dst = (int *)temp;
+        sort_barrier_wait(job);
+    }
+    
+    if (src != job->values) {
+        memcpy(job->values + out_low, src + out_low, (size_t)(out_high - out_low) * sizeof(int));
+    }
+}
+
+static void *sort_worker_main(void *arg) {
+    SortWorker *worker = arg;
+    SortJob *job = worker->job;
+    
+    // Wait until the caller knows how many workers actually started
+    pthread_mutex_lock(&job->barrier.mutex);
+    while (!job->started) {
+        pthread_cond_wait(&job->barrier.cond, &job->barrier.mutex);
+    }
+    bool participating = worker->index < job->thread_count;
+    pthread_mutex_unlock(&job->barrier.mutex);
+    
+    if (participating) {
+        sort_job_work(job, worker->index);
+    }
+    return NULL;
+}
+
+int parallel_sort_thread_count(int n) {
+    long cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (cpus < 1 || n < PARALLEL_SORT_MIN_PARALLEL) {
+        return 1;
+    }
+    
+    long threads = n / PARALLEL_SORT_MIN_PER_THREAD;
+    if (threads > cpus) {
+        threads = cpus;
+    }
+    if (threads > PARALLEL_SORT_MAX_THREADS) {
+        threads = PARALLEL_SORT_MAX_THREADS;
+    }
+    return threads > 1 ? (int)threads : 1;
+}
+
+bool parallel_sort(int *values, int n, ParallelSortCompare compare, const void *context) {
+    if (n < 2) {
+        return true;
+    }
+    int *buffer = malloc((size_t)n * sizeof(int));
+    if (!buffer) {
+        return false;
+    }
+    
+    int threads = parallel_sort_thread_count(n);
+    if (threads == 1) {
+        parallel_sort_run(values, buffer, 0, n, compare, context);
+        free(buffer);
+        return true;
+    }
+    
+    SortJob job = {values, buffer, n, compare, context, 0, false,
+                   {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0}};
+    SortWorker workers[PARALLEL_SORT_MAX_THREADS];
+    pthread_t pool[PARALLEL_SORT_MAX_THREADS];
+    
+    // The calling thread is worker 0; if some workers cannot be started the
+    // job is simply cut into fewer runs
+    int started = 1;
+    for (int i = 1; i < threads; i++) {
+        workers[i] = (SortWorker){&job, i};
+        if (pthread_create(&pool[i], NULL, sort_worker_main, &workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    
+    pthread_mutex_lock(&job.barrier.mutex);
+    job.thread_count = started;
+    job.started = true;
+    pthread_cond_broadcast(&job.barrier.cond);
+    pthread_mutex_unlock(&job.barrier.mutex);
+    
+    sort_job_work(&job, 0);
+    for (int i = 1; i < started; i++) {
+        pthread_join(pool[i], NULL);
+    }
+    
+    pthread_mutex_destroy(&job.barrier.mutex);
+    pthread_cond_destroy(&job.barrier.cond);
+    free(buffer);
+    return true;
+}
\ No newline at end of file
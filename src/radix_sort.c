@@ -0,0 +1,71 @@
+#include "radix_sort.h"
+#include <stdlib.h>
+
+#define RADIX_DIGIT_BITS 11
+#define RADIX_BUCKETS (1 << RADIX_DIGIT_BITS)
+#define RADIX_PASSES ((64 + RADIX_DIGIT_BITS - 1) / RADIX_DIGIT_BITS)
+
+static inline int radix_digit(uint64_t key, int pass) {
+    return (int)(key >> (pass * RADIX_DIGIT_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+bool radix_sort_pairs(uint64_t *keys, int *values, int n) {
+    if (n < 2) {
+        return true;
+    }
+    
+    uint64_t *key_buffer = malloc((size_t)n * sizeof(uint64_t));
+    int *value_buffer = malloc((size_t)n * sizeof(int));
+    int (*counts)[RADIX_BUCKETS] = calloc(RADIX_PASSES, sizeof(*counts));
+    if (!key_buffer || !value_buffer || !counts) {
+        free(key_buffer);
+        free(value_buffer);
+        free(counts);
+        return false;
+    }
+    
+    // One read of the keys builds the histogram of every digit
+    for (int i = 0; i < n; i++) {
+        uint64_t key = keys[i];
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            counts[pass][radix_digit(key, pass)]++;
+        }
+    }
+    
+    uint64_t *src_keys = keys, *dst_keys = key_buffer;
+    int *src_values = values, *dst_values = value_buffer;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        int *offsets = counts[pass];
+        if (offsets[radix_digit(src_keys[0], pass)] == n) {
+            continue;  // Every key has the same digit here
+        }
+        
+        int offset = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            int count = offsets[b];
+            offsets[b] = offset;
+            offset += count;
+        }
+        for (int i = 0; i < n; i++) {
+            int pos = offsets[radix_digit(src_keys[i], pass)]++;
+            dst_keys[pos] = src_keys[i];
+            dst_values[pos] = src_values[i];
+        }
+        
+        uint64_t *temp_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = temp_keys;
+        int *temp_values = src_values;
+        src_values = dst_values;
+        dst_values = temp_values;
+    }
+    
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, (size_t)n * sizeof(uint64_t));
+        memcpy(values, src_values, (size_t)n * sizeof(int));
+    }
+    free(key_buffer);
+    free(value_buffer);
+    free(counts);
+    return true;
+}
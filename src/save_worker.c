@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 200809L  // For pthreads
+#include "save_worker.h"
+#include "csv_io.h"
+#include "snapshot.h"
+
+static void *save_worker_main(void *arg) {
+    SaveWorker *worker = arg;
+    
+    pthread_mutex_lock(&worker->lock);
+    for (;;) {
+        while (!worker->stopping && !worker->requested) {
+            pthread_cond_wait(&worker->wake, &worker->lock);
+        }
+        if (!worker->requested) {
+            break;
+        }
+        worker->requested = false;
+        pthread_mutex_unlock(&worker->lock);
+        
+        // The version stays valid until our reader slot is left
+        bool ok;
+        if (worker->journal) {
+            ok = journal_checkpoint_version(worker->journal, worker->version, worker->position);
+        } else {
+            ok = save_inventory_version_to_file(worker->version, worker->csv_filename);
+            if (ok) {
+                snapshot_save_version(worker->version, worker->snapshot_filename, worker->csv_filename);
+            }
+        }
+        uint64_t version = worker->version->version;
+        worker->version = NULL;
+        inventory_publisher_exit(worker->publisher, worker->reader);
+        if (worker->callback) {
+            worker->callback(ok, version, worker->user_data);
+        }
+        
+        pthread_mutex_lock(&worker->lock);
+        worker->busy = false;
+        pthread_cond_broadcast(&worker->idle);
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return NULL;
+}
+
+bool save_worker_start(SaveWorker *worker, InventoryPublisher *publisher, Journal *journal,
+                       const char *csv_filename, const char *snapshot_filename,
+                       SaveWorkerCallback callback, void *user_data) {
+    worker->reader = inventory_publisher_register(publisher);
+    if (worker->reader < 0) {
+        return false;
+    }
+    worker->publisher = publisher;
+    worker->journal = journal;
+    worker->csv_filename = csv_filename;
+    worker->snapshot_filename = snapshot_filename;
+    worker->callback = callback;
+    worker->user_data = user_data;
+    worker->position = 0;
+    worker->requested = false;
+    worker->busy = false;
+    worker->stopping = false;
+    worker->version = NULL;
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->wake, NULL);
+    pthread_cond_init(&worker->idle, NULL);
+    
+    if (pthread_create(&worker->thread, NULL, save_worker_main, worker) != 0) {
+        pthread_mutex_destroy(&worker->lock);
+        pthread_cond_destroy(&worker->wake);
+        pthread_cond_destroy(&worker->idle);
+        inventory_publisher_unregister(publisher, worker->reader);
+        return false;
+    }
+    return true;
+}
+
+void save_worker_stop(SaveWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    worker->stopping = true;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+    pthread_join(worker->thread, NULL);
+    
+    inventory_publisher_unregister(worker->publisher, worker->reader);
+    pthread_mutex_destroy(&worker->lock);
+    pthread_cond_destroy(&worker->wake);
+    pthread_cond_destroy(&worker->idle);
+}
+
+bool save_worker_request(SaveWorker *worker, Inventory *inv) {
+    if (save_worker_busy(worker)) {
+        return false;
+    }
+    
+    // The worker is idle, so its reader slot is free. Entering it right
+    // after publishing pins this version: nothing else publishes in between,
+    // and a version is not freed while a reader that saw it is inside. The
+    // journal position is taken alongside, before any further edit is recorded.
+    if (!inventory_publisher_publish(worker->publisher, inv)) {
+        return false;
+    }
+    worker->version = inventory_publisher_enter(worker->publisher, worker->reader);
+    worker->position = worker->journal ? journal_position(worker->journal) : 0;
+    
+    pthread_mutex_lock(&worker->lock);
+    worker->requested = true;
+    worker->busy = true;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+    return true;
+}
+
+bool save_worker_busy(SaveWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    bool busy = worker->busy;
+    pthread_mutex_unlock(&worker->lock);
+    return busy;
+}
+
+void save_worker_wait(SaveWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    while (worker->busy) {
+        pthread_cond_wait(&worker->idle, &worker->lock);
+    }
+    pthread_mutex_unlock(&worker->lock);
+}
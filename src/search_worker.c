@@ -0,0 +1,141 @@
+#define _POSIX_C_SOURCE 200809L  // For pthreads
+#include "search_worker.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    SearchWorker *worker;
+    uint64_t generation;
+} SearchTask;
+
+// Polled by inventory_search: a newer request, a cancel, a waiting writer
+// or shutdown all stop the search
+static bool search_task_cancelled(void *data) {
+    SearchTask *task = data;
+    SearchWorker *worker = task->worker;
+    
+    pthread_mutex_lock(&worker->lock);
+    bool cancelled = worker->generation != task->generation || worker->writers > 0 || worker->stopping;
+    pthread_mutex_unlock(&worker->lock);
+    return cancelled;
+}
+
+static void *search_worker_main(void *arg) {
+    SearchWorker *worker = arg;
+    
+    pthread_mutex_lock(&worker->lock);
+    for (;;) {
+        // Searches wait while the owner has (or wants) the inventory
+        while (!worker->stopping && (!worker->query || worker->writers > 0)) {
+            pthread_cond_wait(&worker->wake, &worker->lock);
+        }
+        if (worker->stopping) {
+            break;
+        }
+        char *query = worker->query;
+        worker->query = NULL;
+        SearchTask task = {worker, worker->generation};
+        pthread_mutex_unlock(&worker->lock);
+        
+        pthread_mutex_lock(&worker->inventory_lock);
+        Inventory *inv = worker->inv;
+        int *ids = malloc((size_t)(inv->count > 0 ? inv->count : 1) * sizeof(int));
+        int count = ids ? inventory_search(inv, query, ids, inv->count, search_task_cancelled, &task) : -1;
+        uint64_t version = inv->version;
+        pthread_mutex_unlock(&worker->inventory_lock);
+        
+        pthread_mutex_lock(&worker->lock);
+        if (count >= 0 && worker->generation == task.generation) {
+            pthread_mutex_unlock(&worker->lock);
+            worker->callback(ids, count, task.generation, version, worker->user_data);
+            free(query);
+            pthread_mutex_lock(&worker->lock);
+            continue;
+        }
+        
+        // Interrupted by the owner taking the inventory: run it again unless
+        // a newer request has replaced it in the meantime
+        free(ids);
+        if (worker->generation == task.generation && !worker->query && ids) {
+            worker->query = query;
+        } else {
+            free(query);
+        }
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return NULL;
+}
+
+bool search_worker_start(SearchWorker *worker, Inventory *inv, SearchWorkerCallback callback, void *user_data) {
+    worker->inv = inv;
+    worker->callback = callback;
+    worker->user_data = user_data;
+    worker->query = NULL;
+    worker->generation = 0;
+    worker->writers = 0;
+    worker->stopping = false;
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->wake, NULL);
+    pthread_mutex_init(&worker->inventory_lock, NULL);
+    
+    if (pthread_create(&worker->thread, NULL, search_worker_main, worker) != 0) {
+        pthread_mutex_destroy(&worker->lock);
+        pthread_cond_destroy(&worker->wake);
+        pthread_mutex_destroy(&worker->inventory_lock);
+        return false;
+    }
+    return true;
+}
+
+void search_worker_stop(SearchWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    worker->stopping = true;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+    pthread_join(worker->thread, NULL);
+    
+    free(worker->query);
+    pthread_mutex_destroy(&worker->lock);
+    pthread_cond_destroy(&worker->wake);
+    pthread_mutex_destroy(&worker->inventory_lock);
+}
+
+uint64_t search_worker_request(SearchWorker *worker, const char *query) {
+    size_t length = strlen(query);
+    char *copy = malloc(length + 1);
+    if (!copy) {
+        return 0;
+    }
+    memcpy(copy, query, length + 1);
+    
+    pthread_mutex_lock(&worker->lock);
+    free(worker->query);
+    worker->query = copy;
+    uint64_t generation = ++worker->generation;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+    return generation;
+}
+
+void search_worker_cancel(SearchWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    free(worker->query);
+    worker->query = NULL;
+    worker->generation++;
+    pthread_mutex_unlock(&worker->lock);
+}
+
+void search_worker_lock_inventory(SearchWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    worker->writers++;
+    pthread_mutex_unlock(&worker->lock);
+    pthread_mutex_lock(&worker->inventory_lock);
+}
+
+void search_worker_unlock_inventory(SearchWorker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    worker->writers--;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+    pthread_mutex_unlock(&worker->inventory_lock);
+}
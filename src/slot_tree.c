@@ -0,0 +1,464 @@
+#include "slot_tree.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct SlotTreeNode {
+    int length;  // Slots in a leaf, children in an inner node
+    union {
+        int slots[SLOT_TREE_LEAF_SLOTS];
+        struct {
+            int counts[SLOT_TREE_INNER_CHILDREN];  // Slots under each child
+            int firsts[SLOT_TREE_INNER_CHILDREN];  // First slot under each child, to steer by key
+            SlotTreeNode *children[SLOT_TREE_INNER_CHILDREN];
+        } inner;
+    } u;
+};
+
+// Bulk loads leave a quarter of every node free, so the first inserts after
+// one do not all split
+#define SLOT_TREE_LEAF_FILL (SLOT_TREE_LEAF_SLOTS * 3 / 4)
+#define SLOT_TREE_INNER_FILL (SLOT_TREE_INNER_CHILDREN * 3 / 4)
+
+static void slot_tree_free_node(SlotTreeNode *node, int height) {
+    if (height > 0) {
+        for (int i = 0; i < node->length; i++) {
+            slot_tree_free_node(node->u.inner.children[i], height - 1);
+        }
+    }
+    free(node);
+}
+
+// Drops the contents but keeps the spare nodes
+static void slot_tree_clear(SlotTree *tree) {
+    if (tree->root) {
+        slot_tree_free_node(tree->root, tree->height);
+    }
+    tree->root = NULL;
+    tree->height = 0;
+    tree->length = 0;
+}
+
+void slot_tree_init(SlotTree *tree) {
+    tree->root = NULL;
+    tree->height = 0;
+    tree->length = 0;
+    tree->spare = NULL;
+    tree->spare_count = 0;
+}
+
+void slot_tree_free(SlotTree *tree) {
+    slot_tree_clear(tree);
+    while (tree->spare) {
+        SlotTreeNode *next = tree->spare->u.inner.children[0];
+        free(tree->spare);
+        tree->spare = next;
+    }
+    slot_tree_init(tree);
+}
+
+// Spare nodes are chained through their first child pointer
+static SlotTreeNode *slot_tree_take(SlotTree *tree) {
+    SlotTreeNode *node = tree->spare;
+    tree->spare = node->u.inner.children[0];
+    tree->spare_count--;
+    node->length = 0;
+    return node;
+}
+
+// An insertion splits at most one node per level and then adds a root; the
+// extra level covers the tree growing taller partway through
+bool slot_tree_reserve(SlotTree *tree, int inserts) {
+    long long needed = (long long)inserts * (tree->height + 3);
+    while (tree->spare_count < needed) {
+        SlotTreeNode *node = malloc(sizeof(SlotTreeNode));
+        if (!node) {
+            return false;
+        }
+        node->u.inner.children[0] = tree->spare;
+        tree->spare = node;
+        tree->spare_count++;
+    }
+    return true;
+}
+
+static int slot_tree_first(const SlotTreeNode *node, int height) {
+    return height == 0 ? node->u.slots[0] : node->u.inner.firsts[0];
+}
+
+static int slot_tree_count(const SlotTreeNode *node, int height) {
+    if (height == 0) {
+        return node->length;
+    }
+    int count = 0;
+    for (int i = 0; i < node->length; i++) {
+        count += node->u.inner.counts[i];
+    }
+    return count;
+}
+
+// The child of an inner node whose range takes slot: the last one whose
+// first slot does not sort after it
+static int slot_tree_child(const SlotTreeNode *node, int slot, SlotTreeCompare compare, const void *context) {
+    int low = 1;
+    int high = node->length;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (compare(context, node->u.inner.firsts[mid], slot) <= 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low - 1;
+}
+
+// First index in a leaf whose slot does not sort before slot
+static int slot_tree_leaf_bound(const SlotTreeNode *leaf, int slot, SlotTreeCompare compare, const void *context) {
+    int low = 0;
+    int high = leaf->length;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (compare(context, leaf->u.slots[mid], slot) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Adds a child at index of an inner node that has room for it
+static void slot_tree_inner_put(SlotTreeNode *node, int index, SlotTreeNode *child, int count, int first) {
+    size_t move = (size_t)(node->length - index);
+    memmove(&node->u.inner.counts[index + 1], &node->u.inner.counts[index], move * sizeof(int));
+    memmove(&node->u.inner.firsts[index + 1], &node->u.inner.firsts[index], move * sizeof(int));
+    memmove(&node->u.inner.children[index + 1], &node->u.inner.children[index], move * sizeof(SlotTreeNode *));
+    node->u.inner.counts[index] = count;
+    node->u.inner.firsts[index] = first;
+    node->u.inner.children[index] = child;
+    node->length++;
+}
+
+static void slot_tree_inner_drop(SlotTreeNode *node, int index) {
+    size_t move = (size_t)(node->length - index - 1);
+    memmove(&node->u.inner.counts[index], &node->u.inner.counts[index + 1], move * sizeof(int));
+    memmove(&node->u.inner.firsts[index], &node->u.inner.firsts[index + 1], move * sizeof(int));
+    memmove(&node->u.inner.children[index], &node->u.inner.children[index + 1], move * sizeof(SlotTreeNode *));
+    node->length--;
+}
+
+// Moves the upper half of a full node into a spare one and returns it
+static SlotTreeNode *slot_tree_split(SlotTree *tree, SlotTreeNode *node, int height) {
+    SlotTreeNode *right = slot_tree_take(tree);
+    if (height == 0) {
+        int half = SLOT_TREE_LEAF_SLOTS / 2;
+        right->length = SLOT_TREE_LEAF_SLOTS - half;
+        memcpy(right->u.slots, node->u.slots + half, (size_t)right->length * sizeof(int));
+        node->length = half;
+    } else {
+        int half = SLOT_TREE_INNER_CHILDREN / 2;
+        right->length = SLOT_TREE_INNER_CHILDREN - half;
+        memcpy(right->u.inner.counts, node->u.inner.counts + half, (size_t)right->length * sizeof(int));
+        memcpy(right->u.inner.firsts, node->u.inner.firsts + half, (size_t)right->length * sizeof(int));
+        memcpy(right->u.inner.children, node->u.inner.children + half, (size_t)right->length * sizeof(SlotTreeNode *));
+        node->length = half;
+    }
+    return right;
+}
+
+// Inserts slot below node; returns the new right half if node had to split
+static SlotTreeNode *slot_tree_insert_below(SlotTree *tree, SlotTreeNode *node, int height, int slot,
+                                            SlotTreeCompare compare, const void *context) {
+    if (height == 0) {
+        int pos = slot_tree_leaf_bound(node, slot, compare, context);
+        SlotTreeNode *right = (node->length == SLOT_TREE_LEAF_SLOTS) ? slot_tree_split(tree, node, 0) : NULL;
+        SlotTreeNode *target = node;
+        if (right && pos > node->length) {
+            pos -= node->length;
+            target = right;
+        }
+        memmove(&target->u.slots[pos + 1], &target->u.slots[pos], (size_t)(target->length - pos) * sizeof(int));
+        target->u.slots[pos] = slot;
+        target->length++;
+        return right;
+    }
+    
+    int i = slot_tree_child(node, slot, compare, context);
+    SlotTreeNode *child = node->u.inner.children[i];
+    SlotTreeNode *split = slot_tree_insert_below(tree, child, height - 1, slot, compare, context);
+    node->u.inner.counts[i]++;
+    node->u.inner.firsts[i] = slot_tree_first(child, height - 1);
+    if (!split) {
+        return NULL;
+    }
+    
+    int split_count = slot_tree_count(split, height - 1);
+    node->u.inner.counts[i] -= split_count;
+    SlotTreeNode *right = (node->length == SLOT_TREE_INNER_CHILDREN) ? slot_tree_split(tree, node, height) : NULL;
+    SlotTreeNode *target = node;
+    int index = i + 1;
+    if (right && index > node->length) {
+        index -= node->length;
+        target = right;
+    }
+    slot_tree_inner_put(target, index, split, split_count, slot_tree_first(split, height - 1));
+    return right;
+}
+
+bool slot_tree_insert(SlotTree *tree, int slot, SlotTreeCompare compare, const void *context) {
+    if (!slot_tree_reserve(tree, 1)) {
+        return false;
+    }
+    if (!tree->root) {
+        tree->root = slot_tree_take(tree);
+    }
+    
+    SlotTreeNode *split = slot_tree_insert_below(tree, tree->root, tree->height, slot, compare, context);
+    if (split) {
+        int split_count = slot_tree_count(split, tree->height);
+        SlotTreeNode *root = slot_tree_take(tree);
+        slot_tree_inner_put(root, 0, tree->root, tree->length + 1 - split_count,
+                            slot_tree_first(tree->root, tree->height));
+        slot_tree_inner_put(root, 1, split, split_count, slot_tree_first(split, tree->height));
+        tree->root = root;
+        tree->height++;
+    }
+    tree->length++;
+    return true;
+}
+
+// Folds a child that has dropped below a quarter full into a neighbour when
+// the two fit in one node, so sparse nodes do not pile up after deletes
+static void slot_tree_merge_child(SlotTreeNode *node, int i, int height) {
+    int capacity = (height == 1) ? SLOT_TREE_LEAF_SLOTS : SLOT_TREE_INNER_CHILDREN;
+    int length = node->u.inner.children[i]->length;
+    if (length >= capacity / 4) {
+        return;
+    }
+    
+    int left;
+    if (i + 1 < node->length && node->u.inner.children[i + 1]->length + length <= capacity) {
+        left = i;
+    } else if (i > 0 && node->u.inner.children[i - 1]->length + length <= capacity) {
+        left = i - 1;
+    } else {
+        return;
+    }
+    
+    SlotTreeNode *a = node->u.inner.children[left];
+    SlotTreeNode *b = node->u.inner.children[left + 1];
+    if (height == 1) {
+        memcpy(&a->u.slots[a->length], b->u.slots, (size_t)b->length * sizeof(int));
+    } else {
+        memcpy(&a->u.inner.counts[a->length], b->u.inner.counts, (size_t)b->length * sizeof(int));
+        memcpy(&a->u.inner.firsts[a->length], b->u.inner.firsts, (size_t)b->length * sizeof(int));
+        memcpy(&a->u.inner.children[a->length], b->u.inner.children, (size_t)b->length * sizeof(SlotTreeNode *));
+    }
+    a->length += b->length;
+    node->u.inner.counts[left] += node->u.inner.counts[left + 1];
+    free(b);
+    slot_tree_inner_drop(node, left + 1);
+}
+
+static bool slot_tree_remove_below(SlotTreeNode *node, int height, int slot, SlotTreeCompare compare,
+                                   const void *context) {
+    if (height == 0) {
+        int pos = slot_tree_leaf_bound(node, slot, compare, context);
+        if (pos == node->length || node->u.slots[pos] != slot) {
+            return false;
+        }
+        memmove(&node->u.slots[pos], &node->u.slots[pos + 1], (size_t)(node->length - pos - 1) * sizeof(int));
+        node->length--;
+        return true;
+    }
+    
+    int i = slot_tree_child(node, slot, compare, context);
+    SlotTreeNode *child = node->u.inner.children[i];
+    if (!slot_tree_remove_below(child, height - 1, slot, compare, context)) {
+        return false;
+    }
+    
+    node->u.inner.counts[i]--;
+    if (child->length == 0) {
+        free(child);
+        slot_tree_inner_drop(node, i);
+    } else {
+        node->u.inner.firsts[i] = slot_tree_first(child, height - 1);
+        slot_tree_merge_child(node, i, height);
+    }
+    return true;
+}
+
+bool slot_tree_remove(SlotTree *tree, int slot, SlotTreeCompare compare, const void *context) {
+    if (!tree->root || !slot_tree_remove_below(tree->root, tree->height, slot, compare, context)) {
+        return false;
+    }
+    
+    tree->length--;
+    while (tree->height > 0 && tree->root->length == 1) {
+        SlotTreeNode *root = tree->root;
+        tree->root = root->u.inner.children[0];
+        tree->height--;
+        free(root);
+    }
+    if (tree->length == 0) {
+        slot_tree_clear(tree);
+    }
+    return true;
+}
+
+static bool slot_tree_replace_below(SlotTreeNode *node, int height, int from_slot, int to_slot,
+                                    SlotTreeCompare compare, const void *context) {
+    if (height == 0) {
+        int pos = slot_tree_leaf_bound(node, from_slot, compare, context);
+        if (pos == node->length || node->u.slots[pos] != from_slot) {
+            return false;
+        }
+        node->u.slots[pos] = to_slot;
+        return true;
+    }
+    
+    int i = slot_tree_child(node, from_slot, compare, context);
+    if (!slot_tree_replace_below(node->u.inner.children[i], height - 1, from_slot, to_slot, compare, context)) {
+        return false;
+    }
+    if (node->u.inner.firsts[i] == from_slot) {
+        node->u.inner.firsts[i] = to_slot;
+    }
+    return true;
+}
+
+bool slot_tree_replace(SlotTree *tree, int from_slot, int to_slot, SlotTreeCompare compare, const void *context) {
+    return tree->root && slot_tree_replace_below(tree->root, tree->height, from_slot, to_slot, compare, context);
+}
+
+int slot_tree_rank(const SlotTree *tree, int slot, SlotTreeCompare compare, const void *context) {
+    const SlotTreeNode *node = tree->root;
+    if (!node) {
+        return -1;
+    }
+    
+    int position = 0;
+    for (int height = tree->height; height > 0; height--) {
+        int i = slot_tree_child(node, slot, compare, context);
+        for (int j = 0; j < i; j++) {
+            position += node->u.inner.counts[j];
+        }
+        node = node->u.inner.children[i];
+    }
+    int pos = slot_tree_leaf_bound(node, slot, compare, context);
+    return (pos < node->length && node->u.slots[pos] == slot) ? position + pos : -1;
+}
+
+// The leaf holding position, with position's index in it in *index
+static const SlotTreeNode *slot_tree_leaf_at(const SlotTree *tree, int position, int *index) {
+    const SlotTreeNode *node = tree->root;
+    for (int height = tree->height; height > 0; height--) {
+        int i = 0;
+        while (position >= node->u.inner.counts[i]) {
+            position -= node->u.inner.counts[i++];
+        }
+        node = node->u.inner.children[i];
+    }
+    *index = position;
+    return node;
+}
+
+int slot_tree_select(const SlotTree *tree, int position) {
+    int index;
+    const SlotTreeNode *leaf = slot_tree_leaf_at(tree, position, &index);
+    return leaf->u.slots[index];
+}
+
+void slot_tree_read(const SlotTree *tree, int position, int count, int *slots) {
+    while (count > 0) {
+        int index;
+        const SlotTreeNode *leaf = slot_tree_leaf_at(tree, position, &index);
+        int run = leaf->length - index;
+        if (run > count) {
+            run = count;
+        }
+        memcpy(slots, &leaf->u.slots[index], (size_t)run * sizeof(int));
+        slots += run;
+        position += run;
+        count -= run;
+    }
+}
+
+// Builds the tree bottom up: leaves first, then each level of inner nodes
+// over the one below, spreading entries evenly so no node ends up nearly
+// empty. level holds the nodes of the level being grouped; each parent
+// replaces its first child's entry, which is never read again.
+bool slot_tree_assign(SlotTree *tree, const int *slots, int n) {
+    slot_tree_clear(tree);
+    if (n <= 0) {
+        return true;
+    }
+    
+    int nodes = (n + SLOT_TREE_LEAF_FILL - 1) / SLOT_TREE_LEAF_FILL;
+    SlotTreeNode **level = malloc((size_t)nodes * sizeof(SlotTreeNode *));
+    int *counts = malloc((size_t)nodes * sizeof(int));
+    int built = 0;
+    while (level && counts && built < nodes) {
+        int begin = (int)((long long)n * built / nodes);
+        int end = (int)((long long)n * (built + 1) / nodes);
+        SlotTreeNode *leaf = malloc(sizeof(SlotTreeNode));
+        if (!leaf) {
+            break;
+        }
+        leaf->length = end - begin;
+        memcpy(leaf->u.slots, slots + begin, (size_t)leaf->length * sizeof(int));
+        level[built] = leaf;
+        counts[built++] = leaf->length;
+    }
+    
+    int height = 0;
+    bool ok = built == nodes;
+    while (ok && nodes > 1) {
+        int parents = (nodes + SLOT_TREE_INNER_FILL - 1) / SLOT_TREE_INNER_FILL;
+        int made = 0;
+        for (; made < parents; made++) {
+            int begin = (int)((long long)nodes * made / parents);
+            int end = (int)((long long)nodes * (made + 1) / parents);
+            SlotTreeNode *parent = malloc(sizeof(SlotTreeNode));
+            if (!parent) {
+                break;
+            }
+            parent->length = 0;
+            int total = 0;
+            for (int c = begin; c < end; c++) {
+                slot_tree_inner_put(parent, parent->length, level[c], counts[c], slot_tree_first(level[c], height));
+                total += counts[c];
+            }
+            level[made] = parent;
+            counts[made] = total;
+        }
+        
+        if (made < parents) {
+            // The parents made so far own their children; the rest of the level is loose
+            for (int p = 0; p < made; p++) {
+                slot_tree_free_node(level[p], height + 1);
+            }
+            for (int c = (int)((long long)nodes * made / parents); c < nodes; c++) {
+                slot_tree_free_node(level[c], height);
+            }
+            built = 0;
+            ok = false;
+            break;
+        }
+        nodes = parents;
+        height++;
+    }
+    
+    if (ok) {
+        tree->root = level[0];
+        tree->height = height;
+        tree->length = n;
+    }
+    for (int i = 0; i < built && !ok; i++) {
+        slot_tree_free_node(level[i], 0);
+    }
+    free(level);
+    free(counts);
+    return ok;
+}
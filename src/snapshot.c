@@ -0,0 +1,369 @@
+#include "snapshot.h"
+#include "metrics.h"
+#include "csv_io.h"
+#include "file_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_WRITE_BUFFER_SIZE (1 << 16)
+
+#define SNAPSHOT_PRIME_1 0x9E3779B185EBCA87ULL
+#define SNAPSHOT_PRIME_2 0xC2B2AE3D27D4EB4FULL
+
+// Four independent multiply-rotate lanes over 64-bit words, so the checksum
+// runs at close to memory speed. Data is always fed in whole words.
+typedef struct {
+    uint64_t lanes[4];
+    uint64_t words;
+} SnapshotChecksum;
+
+// Byte offsets of each section from the start of the file
+typedef struct {
+    size_t ids;
+    size_t quantities;
+    size_t prices;
+    size_t reorder_levels;
+    size_t name_offsets;
+    size_t name_lengths;
+    size_t names;
+    size_t end;
+} SnapshotLayout;
+
+typedef struct {
+    FILE *file;
+    unsigned char buffer[SNAPSHOT_WRITE_BUFFER_SIZE];
+    size_t used;
+    SnapshotChecksum checksum;
+    bool failed;
+} SnapshotWriter;
+
+static uint64_t snapshot_rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t snapshot_round(uint64_t lane, uint64_t word) {
+    return snapshot_rotl(lane + word * SNAPSHOT_PRIME_2, 31) * SNAPSHOT_PRIME_1;
+}
+
+static void snapshot_checksum_init(SnapshotChecksum *checksum) {
+    for (int i = 0; i < 4; i++) {
+        checksum->lanes[i] = SNAPSHOT_PRIME_1 * (uint64_t)(i + 1);
+    }
+    checksum->words = 0;
+}
+
+// size must be a multiple of 8
+static void snapshot_checksum_update(SnapshotChecksum *checksum, const unsigned char *data, size_t size) {
+    size_t i = 0;
+    for (; i < size && (checksum->words & 3) != 0; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        uint64_t *lane = &checksum->lanes[checksum->words & 3];
+        *lane = snapshot_round(*lane, word);
+        checksum->words++;
+    }
+    for (; i + 32 <= size; i += 32) {
+        uint64_t words[4];
+        memcpy(words, data + i, 32);
+        checksum->lanes[0] = snapshot_round(checksum->lanes[0], words[0]);
+        checksum->lanes[1] = snapshot_round(checksum->lanes[1], words[1]);
+        checksum->lanes[2] = snapshot_round(checksum->lanes[2], words[2]);
+        checksum->lanes[3] = snapshot_round(checksum->lanes[3], words[3]);
+        checksum->words += 4;
+    }
+    for (; i < size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        uint64_t *lane = &checksum->lanes[checksum->words & 3];
+        *lane = snapshot_round(*lane, word);
+        checksum->words++;
+    }
+}
+
+static uint64_t snapshot_checksum_final(const SnapshotChecksum *checksum) {
+    uint64_t hash = snapshot_rotl(checksum->lanes[0], 1) + snapshot_rotl(checksum->lanes[1], 7) +
+                    snapshot_rotl(checksum->lanes[2], 12) + snapshot_rotl(checksum->lanes[3], 18);
+    hash += checksum->words;
+    hash ^= hash >> 33;
+    hash *= SNAPSHOT_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= SNAPSHOT_PRIME_1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static size_t snapshot_align(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+static bool snapshot_layout(SnapshotLayout *layout, int32_t count, uint64_t names_size) {
+    if (count < 0 || names_size > UINT32_MAX) {
+        return false;
+    }
+    
+    size_t n = (size_t)count;
+    layout->ids = snapshot_align(sizeof(SnapshotHeader));
+    layout->quantities = layout->ids + snapshot_align(n * sizeof(int32_t));
+    layout->prices = layout->quantities + snapshot_align(n * sizeof(int32_t));
+    layout->reorder_levels = layout->prices + snapshot_align(n * sizeof(float));
+    layout->name_offsets = layout->reorder_levels + snapshot_align(n * sizeof(int32_t));
+    layout->name_lengths = layout->name_offsets + snapshot_align(n * sizeof(uint32_t));
+    layout->names = layout->name_lengths + snapshot_align(n * sizeof(uint8_t));
+    layout->end = layout->names + snapshot_align((size_t)names_size);
+    return true;
+}
+
+static void snapshot_writer_flush(SnapshotWriter *writer) {
+    snapshot_checksum_update(&writer->checksum, writer->buffer, writer->used);
+    if (!writer->failed && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        writer->failed = true;
+    }
+    writer->used = 0;
+}
+
+// Only full buffers are flushed before the end, so the checksum always sees whole words
+static void snapshot_writer_put(SnapshotWriter *writer, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    while (size > 0) {
+        size_t chunk = SNAPSHOT_WRITE_BUFFER_SIZE - writer->used;
+        if (chunk > size) {
+            chunk = size;
+        }
+        memcpy(writer->buffer + writer->used, bytes, chunk);
+        writer->used += chunk;
+        bytes += chunk;
+        size -= chunk;
+        if (writer->used == SNAPSHOT_WRITE_BUFFER_SIZE) {
+            snapshot_writer_flush(writer);
+        }
+    }
+}
+
+// Zero-pads the current section to the next 8-byte boundary
+static void snapshot_writer_pad(SnapshotWriter *writer, size_t section_size) {
+    static const unsigned char zeros[8] = {0};
+    snapshot_writer_put(writer, zeros, snapshot_align(section_size) - section_size);
+}
+
+// Rows to write, from either the live inventory or a published version;
+// both are walked in display order
+typedef struct {
+    const Inventory *inv;             // Set for the live inventory
+    const InventoryVersion *version;  // Set otherwise
+    int count;
+    int next_id;
+} SnapshotSource;
+
+typedef struct {
+    int32_t id;
+    int32_t quantity;
+    float price;
+    int32_t reorder_level;
+    const char *name;
+    uint8_t name_length;
+} SnapshotRow;
+
+// Reads the row after *cursor (0 to start) in display order; false at the end
+static bool snapshot_source_next(const SnapshotSource *source, int *cursor, SnapshotRow *row) {
+    if (source->inv) {
+        const Inventory *inv = source->inv;
+        while (*cursor < inv->order_length && inv->order[*cursor] < 0) {
+            (*cursor)++;  // Deleted entry awaiting compaction
+        }
+        if (*cursor == inv->order_length) {
+            return false;
+        }
+        int slot = inv->order[(*cursor)++];
+        row->id = inv->ids[slot];
+        row->quantity = inv->quantities[slot];
+        row->price = inv->prices[slot];
+        row->reorder_level = inv->reorder_levels[slot];
+        row->name = inventory_name_at(inv, slot);
+        row->name_length = inv->name_lengths[slot];
+        return true;
+    }
+    
+    if (*cursor == source->count) {
+        return false;
+    }
+    int slot = inventory_version_slot_at(source->version, (*cursor)++);
+    const InventoryChunk *chunk = source->version->chunks[slot / INVENTORY_CHUNK_ROWS];
+    int i = slot % INVENTORY_CHUNK_ROWS;
+    row->id = chunk->ids[i];
+    row->quantity = chunk->quantities[i];
+    row->price = chunk->prices[i];
+    row->reorder_level = chunk->reorder_levels[i];
+    row->name = chunk->names + chunk->name_offsets[i];
+    row->name_length = chunk->name_lengths[i];
+    return true;
+}
+
+static bool snapshot_write(const SnapshotSource *source, const char *filename, const char *source_filename) {
+    METRICS_START(start);
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.count = source->count;
+    header.next_id = source->next_id;
+    if (!file_stamp_get(source_filename, &header.source)) {
+        return false;
+    }
+    
+    // Names are repacked in display order, dropping heap garbage
+    SnapshotRow row;
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        header.names_size += (uint64_t)row.name_length + 1;
+    }
+    
+    SnapshotLayout layout;
+    SnapshotWriter *writer = malloc(sizeof(SnapshotWriter));
+    AtomicFile output;
+    if (!snapshot_layout(&layout, header.count, header.names_size) || !writer) {
+        free(writer);
+        return false;
+    }
+    if (!atomic_file_open(&output, filename)) {
+        free(writer);
+        return false;
+    }
+    writer->file = output.file;
+    writer->used = 0;
+    writer->failed = false;
+    snapshot_checksum_init(&writer->checksum);
+    
+    // The header is rewritten once the checksum is known
+    static const unsigned char placeholder[sizeof(SnapshotHeader) + 8] = {0};
+    if (fwrite(placeholder, 1, layout.ids, writer->file) != layout.ids) {
+        writer->failed = true;
+    }
+    
+    // One pass over the display order per column keeps every write sequential
+    size_t n = (size_t)header.count;
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        snapshot_writer_put(writer, &row.id, sizeof(int32_t));
+    }
+    snapshot_writer_pad(writer, n * sizeof(int32_t));
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        snapshot_writer_put(writer, &row.quantity, sizeof(int32_t));
+    }
+    snapshot_writer_pad(writer, n * sizeof(int32_t));
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        snapshot_writer_put(writer, &row.price, sizeof(float));
+    }
+    snapshot_writer_pad(writer, n * sizeof(float));
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        snapshot_writer_put(writer, &row.reorder_level, sizeof(int32_t));
+    }
+    snapshot_writer_pad(writer, n * sizeof(int32_t));
+    
+    uint32_t offset = 0;
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        snapshot_writer_put(writer, &offset, sizeof(uint32_t));
+        offset += (uint32_t)row.name_length + 1;
+    }
+    snapshot_writer_pad(writer, n * sizeof(uint32_t));
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        snapshot_writer_put(writer, &row.name_length, sizeof(uint8_t));
+    }
+    snapshot_writer_pad(writer, n * sizeof(uint8_t));
+    for (int cursor = 0; snapshot_source_next(source, &cursor, &row);) {
+        snapshot_writer_put(writer, row.name, (size_t)row.name_length + 1);
+    }
+    snapshot_writer_pad(writer, (size_t)header.names_size);
+    snapshot_writer_flush(writer);
+    
+    header.checksum = snapshot_checksum_final(&writer->checksum);
+    bool failed = writer->failed || fseek(output.file, 0, SEEK_SET) != 0 ||
+                  fwrite(&header, sizeof(header), 1, output.file) != 1;
+    free(writer);
+    if (failed) {
+        atomic_file_abort(&output);
+        return false;
+    }
+    bool committed = atomic_file_commit(&output);
+    METRICS_RECORD(METRIC_SAVE, start, layout.end);
+    return committed;
+}
+
+bool snapshot_save(const Inventory *inv, const char *filename, const char *source_filename) {
+    SnapshotSource source = {inv, NULL, inv->count, inv->next_id};
+    return snapshot_write(&source, filename, source_filename);
+}
+
+bool snapshot_save_version(const InventoryVersion *version, const char *filename, const char *source_filename) {
+    SnapshotSource source = {NULL, version, version->count, version->next_id};
+    return snapshot_write(&source, filename, source_filename);
+}
+
+bool snapshot_load(Inventory *inv, const char *filename, const char *source_filename) {
+    METRICS_START(start);
+    FileStamp source;
+    if (!file_stamp_get(source_filename, &source)) {
+        return false;
+    }
+    
+    MappedFile file;
+    if (!mapped_file_open(&file, filename)) {
+        return false;
+    }
+    
+    SnapshotHeader header;
+    SnapshotLayout layout;
+    bool valid = file.size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, file.data, sizeof(header));
+        valid = memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+                header.version == SNAPSHOT_VERSION &&
+                header.byte_order == SNAPSHOT_BYTE_ORDER &&
+                file_stamp_equal(&header.source, &source) &&
+                snapshot_layout(&layout, header.count, header.names_size) &&
+                layout.end == file.size;
+    }
+    if (valid) {
+        SnapshotChecksum checksum;
+        snapshot_checksum_init(&checksum);
+        snapshot_checksum_update(&checksum, (const unsigned char *)file.data + layout.ids, layout.end - layout.ids);
+        valid = snapshot_checksum_final(&checksum) == header.checksum;
+    }
+    if (valid) {
+        // Columns are used in place; inventory_load_columns copies them out
+        InventoryColumns columns;
+        columns.count = header.count;
+        columns.next_id = header.next_id;
+        columns.ids = (const int *)(file.data + layout.ids);
+        columns.quantities = (const int *)(file.data + layout.quantities);
+        columns.prices = (const float *)(file.data + layout.prices);
+        columns.reorder_levels = (const int *)(file.data + layout.reorder_levels);
+        columns.name_offsets = (const uint32_t *)(file.data + layout.name_offsets);
+        columns.name_lengths = (const uint8_t *)(file.data + layout.name_lengths);
+        columns.names = file.data + layout.names;
+        columns.names_size = (size_t)header.names_size;
+        valid = inventory_load_columns(inv, &columns);
+        if (valid) {
+            inventory_mark_saved(inv, inv->version);
+        }
+    }
+    
+    mapped_file_close(&file);
+    if (valid) {
+        METRICS_RECORD(METRIC_LOAD, start, file.size);
+    }
+    return valid;
+}
+
+bool load_inventory_with_snapshot(Inventory *inv, const char *csv_filename, const char *snapshot_filename) {
+    if (snapshot_load(inv, snapshot_filename, csv_filename)) {
+        return true;
+    }
+    if (!load_inventory_from_file(inv, csv_filename)) {
+        return false;
+    }
+    
+    // Best effort; without it the next start simply parses the CSV again
+    snapshot_save(inv, snapshot_filename, csv_filename);
+    return true;
+}
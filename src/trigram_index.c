@@ -0,0 +1,244 @@
+#include "trigram_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define TRIGRAM_INDEX_MIN_CAPACITY 1024
+#define MAX_TRIGRAMS_PER_KEY 256
+
+static unsigned char trigram_fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+// Distinct lowercase trigrams of text, sorted; returns how many were written
+static int trigram_collect(const char *text, uint32_t *trigrams, int max_trigrams) {
+    size_t length = strlen(text);
+    int count = 0;
+    
+    for (size_t i = 0; i + 2 < length && count < max_trigrams; i++) {
+        uint32_t trigram = ((uint32_t)trigram_fold((unsigned char)text[i]) << 16) |
+                           ((uint32_t)trigram_fold((unsigned char)text[i + 1]) << 8) |
+                           (uint32_t)trigram_fold((unsigned char)text[i + 2]);
+        
+        // Insertion sort with de-duplication; keys are short
+        int pos = count;
+        while (pos > 0 && trigrams[pos - 1] > trigram) {
+            pos--;
+        }
+        if (pos > 0 && trigrams[pos - 1] == trigram) {
+            continue;
+        }
+        memmove(&trigrams[pos + 1], &trigrams[pos], (size_t)(count - pos) * sizeof(uint32_t));
+        trigrams[pos] = trigram;
+        count++;
+    }
+    return count;
+}
+
+static int trigram_bucket(uint32_t trigram, int capacity) {
+    uint32_t hash = trigram * 2654435769u;
+    return (int)((hash >> 8) & (uint32_t)(capacity - 1));
+}
+
+void trigram_index_init(TrigramIndex *index) {
+    index->buckets = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    index->built = false;
+}
+
+void trigram_index_free(TrigramIndex *index) {
+    for (int i = 0; i < index->capacity; i++) {
+        free(index->buckets[i].ids);
+    }
+    free(index->buckets);
+    trigram_index_init(index);
+}
+
+static const TrigramPosting* trigram_index_lookup(const TrigramIndex *index, uint32_t trigram) {
+    if (index->count == 0) {
+        return NULL;
+    }
+    
+    int bucket = trigram_bucket(trigram, index->capacity);
+    while (index->buckets[bucket].trigram != 0) {
+        if (index->buckets[bucket].trigram == trigram) {
+            return &index->buckets[bucket];
+        }
+        bucket = (bucket + 1) & (index->capacity - 1);
+    }
+    return NULL;
+}
+
+static bool trigram_index_grow(TrigramIndex *index) {
+    int new_capacity = (index->capacity > 0) ? index->capacity * 2 : TRIGRAM_INDEX_MIN_CAPACITY;
+    TrigramPosting *buckets = calloc((size_t)new_capacity, sizeof(TrigramPosting));
+    if (!buckets) {
+        return false;
+    }
+    
+    for (int i = 0; i < index->capacity; i++) {
+        if (index->buckets[i].trigram != 0) {
+            int bucket = trigram_bucket(index->buckets[i].trigram, new_capacity);
+            while (buckets[bucket].trigram != 0) {
+                bucket = (bucket + 1) & (new_capacity - 1);
+            }
+            buckets[bucket] = index->buckets[i];
+        }
+    }
+    
+    free(index->buckets);
+    index->buckets = buckets;
+    index->capacity = new_capacity;
+    return true;
+}
+
+// Posting lists are never removed, so the table only needs to grow
+static TrigramPosting* trigram_index_lookup_or_create(TrigramIndex *index, uint32_t trigram) {
+    if ((index->count + 1) * 2 > index->capacity && !trigram_index_grow(index)) {
+        return NULL;
+    }
+    
+    int bucket = trigram_bucket(trigram, index->capacity);
+    while (index->buckets[bucket].trigram != 0) {
+        if (index->buckets[bucket].trigram == trigram) {
+            return &index->buckets[bucket];
+        }
+        bucket = (bucket + 1) & (index->capacity - 1);
+    }
+    
+    index->buckets[bucket].trigram = trigram;
+    index->count++;
+    return &index->buckets[bucket];
+}
+
+// First position in the posting list whose id is not below id
+static int posting_lower_bound(const TrigramPosting *posting, int id) {
+    int low = 0;
+    int high = posting->length;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (posting->ids[mid] < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static bool posting_insert(TrigramPosting *posting, int id) {
+    if (posting->length == posting->capacity) {
+        int new_capacity = (posting->capacity > 0) ? posting->capacity * 2 : 4;
+        if (posting->capacity > INT_MAX / 2) {
+            return false;
+        }
+        int *ids = realloc(posting->ids, (size_t)new_capacity * sizeof(int));
+        if (!ids) {
+            return false;
+        }
+        posting->ids = ids;
+        posting->capacity = new_capacity;
+    }
+    
+    // New items get increasing ids, so this is almost always an append
+    int pos = posting->length;
+    if (pos > 0 && posting->ids[pos - 1] > id) {
+        pos = posting_lower_bound(posting, id);
+        memmove(&posting->ids[pos + 1], &posting->ids[pos], (size_t)(posting->length - pos) * sizeof(int));
+    }
+    posting->ids[pos] = id;
+    posting->length++;
+    return true;
+}
+
+bool trigram_index_add(TrigramIndex *index, int id, const char *name) {
+    uint32_t trigrams[MAX_TRIGRAMS_PER_KEY];
+    int count = trigram_collect(name, trigrams, MAX_TRIGRAMS_PER_KEY);
+    
+    for (int i = 0; i < count; i++) {
+        TrigramPosting *posting = trigram_index_lookup_or_create(index, trigrams[i]);
+        if (!posting || !posting_insert(posting, id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void trigram_index_remove(TrigramIndex *index, int id, const char *name) {
+    uint32_t trigrams[MAX_TRIGRAMS_PER_KEY];
+    int count = trigram_collect(name, trigrams, MAX_TRIGRAMS_PER_KEY);
+    
+    for (int i = 0; i < count; i++) {
+        TrigramPosting *posting = (TrigramPosting *)trigram_index_lookup(index, trigrams[i]);
+        if (!posting) {
+            continue;
+        }
+        
+        int pos = posting_lower_bound(posting, id);
+        if (pos < posting->length && posting->ids[pos] == id) {
+            memmove(&posting->ids[pos], &posting->ids[pos + 1], (size_t)(posting->length - pos - 1) * sizeof(int));
+            posting->length--;
+        }
+    }
+}
+
+int trigram_index_query(const TrigramIndex *index, const char *query, int **ids) {
+    uint32_t trigrams[MAX_TRIGRAMS_PER_KEY];
+    const TrigramPosting *postings[MAX_TRIGRAMS_PER_KEY];
+    
+    *ids = NULL;
+    if (strlen(query) < TRIGRAM_MIN_QUERY_LENGTH) {
+        return -1;
+    }
+    
+    int count = trigram_collect(query, trigrams, MAX_TRIGRAMS_PER_KEY);
+    for (int i = 0; i < count; i++) {
+        postings[i] = trigram_index_lookup(index, trigrams[i]);
+        if (!postings[i] || postings[i]->length == 0) {
+            return 0;  // Some trigram occurs in no name, so nothing can match
+        }
+    }
+    
+    // Intersect shortest-first so the candidate set only shrinks
+    for (int i = 1; i < count; i++) {
+        const TrigramPosting *posting = postings[i];
+        int j = i;
+        while (j > 0 && postings[j - 1]->length > posting->length) {
+            postings[j] = postings[j - 1];
+            j--;
+        }
+        postings[j] = posting;
+    }
+    
+    int length = postings[0]->length;
+    int *candidates = malloc((size_t)(length > 0 ? length : 1) * sizeof(int));
+    if (!candidates) {
+        return -1;
+    }
+    memcpy(candidates, postings[0]->ids, (size_t)length * sizeof(int));
+    
+    for (int i = 1; i < count && length > 0; i++) {
+        int kept = 0;
+        int low = 0;
+        for (int k = 0; k < length; k++) {
+            // Candidates ascend, so each search can start where the last one ended
+            int high = postings[i]->length;
+            while (low < high) {
+                int mid = low + (high - low) / 2;
+                if (postings[i]->ids[mid] < candidates[k]) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if (low < postings[i]->length && postings[i]->ids[low] == candidates[k]) {
+                candidates[kept++] = candidates[k];
+            }
+        }
+        length = kept;
+    }
+    
+    *ids = candidates;
+    return length;
+}
@@ -3,7 +3,13 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdio.h>
-#include <gtk/gtk.h>
+#include <limits.h>
+#include <math.h>  // For isfinite
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 bool validate_name(const char *name) {
     if (!name || strlen(name) == 0) {
@@ -44,7 +50,8 @@ bool validate_price(const char *price_str, float *price) {
     char *endptr;
     double val = strtod(price_str, &endptr);
     
-    if (*endptr != '\0' || val < 0.0) {
+    // "nan", "inf" and values too large for a float are not prices
+    if (*endptr != '\0' || !isfinite(val) || val < 0.0 || !isfinite((float)val)) {
         return false;
     }
     
@@ -52,91 +59,6 @@ bool validate_price(const char *price_str, float *price) {
     return true;
 }
 
-bool save_inventory_to_file(const Inventory *inv, const char *filename) {
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        return false;
-    }
-    
-    // Write CSV header
-    fprintf(file, "ID,Name,Quantity,Price\n");
-    
-    // Write inventory items
-    for (int i = 0; i < inv->count; i++) {
-        const InventoryItem *item = &inv->items[i];
-        fprintf(file, "%d,\"%s\",%d,%.2f\n", item->id, item->name, item->quantity, item->price);
-    }
-    
-    fclose(file);
-    return true;
-}
-
-bool load_inventory_from_file(Inventory *inv, const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        return false;
-    }
-    
-    inventory_init(inv);
-    
-    char line[256];
-    bool first_line = true;
-    int max_id = 0;
-    
-    while (fgets(line, sizeof(line), file) && inv->count < MAX_ITEMS) {
-        // Skip header line
-        if (first_line) {
-            first_line = false;
-            continue;
-        }
-        
-        // Parse CSV line
-        char name[MAX_NAME_LENGTH];
-        int id, quantity;
-        float price;
-        
-        // Simple CSV parsing (handles quoted names)
-        char *token = strtok(line, ",");
-        if (!token) continue;
-        id = atoi(token);
-        
-        token = strtok(NULL, ",");
-        if (!token) continue;
-        // Remove quotes if present
-        if (token[0] == '"') {
-            token++;
-            char *end_quote = strrchr(token, '"');
-            if (end_quote) *end_quote = '\0';
-        }
-        strncpy(name, token, MAX_NAME_LENGTH - 1);
-        name[MAX_NAME_LENGTH - 1] = '\0';
-        
-        token = strtok(NULL, ",");
-        if (!token) continue;
-        quantity = atoi(token);
-        
-        token = strtok(NULL, ",\n");
-        if (!token) continue;
-        price = atof(token);
-        
-        // Add item to inventory
-        InventoryItem *item = &inv->items[inv->count];
-        item->id = id;
-        strcpy(item->name, name);
-        item->quantity = quantity;
-        item->price = price;
-        inv->count++;
-        
-        if (id > max_id) {
-            max_id = id;
-        }
-    }
-    
-    inv->next_id = max_id + 1;
-    fclose(file);
-    return true;
-}
-
 void trim_string(char *str) {
     if (!str) return;
     
@@ -154,30 +76,121 @@ void trim_string(char *str) {
     str[len] = '\0';
 }
 
-bool string_contains_ignore_case(const char *haystack, const char *needle) {
-    if (!haystack || !needle) return false;
-    
-    char *haystack_lower = g_ascii_strdown(haystack, -1);
-    char *needle_lower = g_ascii_strdown(needle, -1);
-    
-    bool result = (strstr(haystack_lower, needle_lower) != NULL);
-    
-    g_free(haystack_lower);
-    g_free(needle_lower);
-    
-    return result;
+void format_cents(char *buffer, size_t size, int64_t cents) {
+    // Negate in unsigned arithmetic so INT64_MIN does not overflow
+    uint64_t magnitude = cents < 0 ? 0 - (uint64_t)cents : (uint64_t)cents;
+    snprintf(buffer, size, "%s%llu.%02llu", cents < 0 ? "-" : "", (unsigned long long)(magnitude / 100),
+             (unsigned long long)(magnitude % 100));
+}
+
+static inline unsigned char ascii_fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
 }
 
-void show_error_dialog(GtkWidget *parent, const char *message) {
-    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
-        GTK_DIALOG_MODAL, GTK_MESSAGE_ERROR, GTK_BUTTONS_OK, "%s", message);
-    gtk_dialog_run(GTK_DIALOG(dialog));
-    gtk_widget_destroy(dialog);
+// Compares n bytes of a and b, ignoring ASCII case
+static bool ascii_equal_ignore_case(const char *a, const char *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (ascii_fold((unsigned char)a[i]) != ascii_fold((unsigned char)b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void string_matcher_init(StringMatcher *matcher, const char *needle) {
+    matcher->needle = needle;
+    matcher->length = strlen(needle);
+    matcher->first = matcher->length ? ascii_fold((unsigned char)needle[0]) : 0;
+    matcher->last = matcher->length ? ascii_fold((unsigned char)needle[matcher->length - 1]) : 0;
+}
+
+// Checks the bytes between the first and last, which the filter already matched
+static inline bool string_matcher_verify(const StringMatcher *matcher, const char *candidate) {
+    return matcher->length <= 2 ||
+           ascii_equal_ignore_case(candidate + 1, matcher->needle + 1, matcher->length - 2);
+}
+
+#if defined(__AVX2__)
+// Lowercases A-Z in all 32 lanes; bytes >= 0x80 compare as negative and are left alone
+static inline __m256i fold_256(__m256i v) {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+    return _mm256_add_epi8(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+#endif
+
+#if defined(__SSE2__)
+static inline __m128i fold_128(__m128i v) {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    return _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+// First-and-last-byte filter: a block of candidate start positions is kept
+// only where both the first needle byte and the byte length - 1 further on
+// match, and only those few positions are verified byte by byte. Vector
+// loads stay inside the haystack; the tail is finished by the scalar loop.
+bool string_matcher_find(const StringMatcher *matcher, const char *haystack, size_t haystack_length) {
+    size_t n = matcher->length;
+    if (n == 0) {
+        return true;
+    }
+    if (n > haystack_length) {
+        return false;
+    }
+    
+    size_t last_start = haystack_length - n;  // Last valid start position
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i first_256 = _mm256_set1_epi8((char)matcher->first);
+    const __m256i last_256 = _mm256_set1_epi8((char)matcher->last);
+    for (; i + 32 <= last_start + 1; i += 32) {
+        __m256i block_first = fold_256(_mm256_loadu_si256((const __m256i *)(haystack + i)));
+        __m256i block_last = fold_256(_mm256_loadu_si256((const __m256i *)(haystack + i + n - 1)));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first_256), _mm256_cmpeq_epi8(block_last, last_256)));
+        while (mask) {
+            if (string_matcher_verify(matcher, haystack + i + __builtin_ctz(mask))) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i first_128 = _mm_set1_epi8((char)matcher->first);
+    const __m128i last_128 = _mm_set1_epi8((char)matcher->last);
+    for (; i + 16 <= last_start + 1; i += 16) {
+        __m128i block_first = fold_128(_mm_loadu_si128((const __m128i *)(haystack + i)));
+        __m128i block_last = fold_128(_mm_loadu_si128((const __m128i *)(haystack + i + n - 1)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first_128), _mm_cmpeq_epi8(block_last, last_128)));
+        while (mask) {
+            if (string_matcher_verify(matcher, haystack + i + __builtin_ctz(mask))) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    
+    for (; i <= last_start; i++) {
+        if (ascii_fold((unsigned char)haystack[i]) == matcher->first &&
+            ascii_fold((unsigned char)haystack[i + n - 1]) == matcher->last &&
+            string_matcher_verify(matcher, haystack + i)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void show_info_dialog(GtkWidget *parent, const char *message) {
-    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
-        GTK_DIALOG_MODAL, GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", message);
-    gtk_dialog_run(GTK_DIALOG(dialog));
-    gtk_widget_destroy(dialog);
+bool string_contains_ignore_case(const char *haystack, const char *needle) {
+    if (!haystack || !needle) return false;
+    
+    StringMatcher matcher;
+    string_matcher_init(&matcher, needle);
+    return string_matcher_find(&matcher, haystack, strlen(haystack));
 }
\ No newline at end of file